@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include "simulation.h"
+#include "thread_pool.h"
+
+// Nothing but the physics and the creature rules: no GL, no accounting, no eviction or lineage, and a
+// cheaper RNG. The tick compiles down to the work every configuration has to do.
+struct BenchConfig {
+    typedef NullRenderer Renderer;
+    typedef ParticleFood Food;
+    typedef RandomForceLocomotion Locomotion;
+    typedef XorShiftRng Rng;
+    typedef NoInstrumentation Instrumentation;
+};
+
+// Runs the simulation headless for a fixed number of ticks and reports the throughput.
+int main(int argc, char **argv) {
+    unsigned long ticks = 10000;
+    int threads = 1;
+    SimulationParams params;
+    params.seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        bool valid = true;
+
+        if (strcmp(arg, "--ticks") == 0 && hasValue) {
+            ticks = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+            params.seed = static_cast<uint32>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(arg, "--param") == 0 && i + 2 < argc) {
+            const char *name = argv[++i];
+            valid = setSimulationParam(params, name, atof(argv[++i]));
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            std::cerr << "Usage: " << argv[0] << " [--ticks N] [--threads N] [--seed N] [--param NAME VALUE]" << std::endl
+                      << "Parameters: " << simulationParamNames() << std::endl;
+            return 1;
+        }
+    }
+
+    // 1 keeps the whole tick on this thread; more splits the per-creature passes across a pool
+    std::unique_ptr<ThreadPool> pool;
+    if (threads != 1) {
+        pool.reset(new ThreadPool(threads));
+    }
+
+    Simulation<BenchConfig> simulation(params, nullptr, pool.get());
+
+    auto start = std::chrono::steady_clock::now();
+    while (simulation.getTick() < ticks && !simulation.getCreatures().empty()) {
+        simulation.step();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << simulation.getTick() << " ticks in " << elapsed.count() << " s ("
+              << (elapsed.count() > 0.0 ? simulation.getTick() / elapsed.count() : 0.0) << " ticks/s), "
+              << simulation.getCreatures().size() << " creatures, "
+              << simulation.getParticleSystem()->GetParticleCount() << " particles, "
+              << (pool ? pool->size() : 1) << " threads" << std::endl;
+    return 0;
+}
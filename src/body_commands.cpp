@@ -0,0 +1,49 @@
+#include "body_commands.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+void BodyCommandQueue::commit() {
+    for (const Command &command: commands) {
+        switch (command.type) {
+            case Command::SetTransform:
+                command.body->SetTransform(command.vector, command.angle);
+                break;
+            case Command::ApplyForceToCenter:
+                command.body->ApplyForceToCenter(command.vector, true);
+                break;
+        }
+    }
+    commands.clear();
+}
+
+BodyCommandBuffer::BodyCommandBuffer(int workers) : queueCount(std::max(1, workers)) {
+    const size_t alignment = alignof(BodyCommandQueue);
+    storage.reset(new char[queueCount * sizeof(BodyCommandQueue) + alignment - 1]);
+
+    auto address = reinterpret_cast<uintptr_t>(storage.get());
+    queues = reinterpret_cast<BodyCommandQueue *>((address + alignment - 1) / alignment * alignment);
+    for (int i = 0; i < queueCount; ++i) {
+        new(&queues[i]) BodyCommandQueue();
+    }
+}
+
+BodyCommandBuffer::~BodyCommandBuffer() {
+    for (int i = 0; i < queueCount; ++i) {
+        queues[i].~BodyCommandQueue();
+    }
+}
+
+size_t BodyCommandBuffer::size() const {
+    size_t total = 0;
+    for (int i = 0; i < queueCount; ++i) {
+        total += queues[i].size();
+    }
+    return total;
+}
+
+void BodyCommandBuffer::commit() {
+    for (int i = 0; i < queueCount; ++i) {
+        queues[i].commit();
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef LIQUIDFUN_EVO_SIM_BODY_COMMANDS_H
+#define LIQUIDFUN_EVO_SIM_BODY_COMMANDS_H
+
+#include <Box2D/Box2D.h>
+#include <memory>
+#include <vector>
+
+// Box2D calls staged by one worker thread. Box2D is not thread-safe, so passes that run on the thread pool
+// record what they want done to bodies here and the main thread replays it. Workers push to neighbouring
+// queues at the same time, so each one gets its own cache line.
+class alignas(64) BodyCommandQueue {
+public:
+    void setTransform(b2Body *body, const b2Vec2 &position, float angle) {
+        commands.push_back({Command::SetTransform, body, position, angle});
+    }
+
+    void applyForceToCenter(b2Body *body, const b2Vec2 &force) {
+        commands.push_back({Command::ApplyForceToCenter, body, force, 0.0f});
+    }
+
+    size_t size() const { return commands.size(); }
+
+    // Applies the commands in the order they were staged and empties the queue
+    void commit();
+
+private:
+    struct Command {
+        enum Type { SetTransform, ApplyForceToCenter } type;
+        b2Body *body;
+        b2Vec2 vector;
+        float angle;
+    };
+
+    std::vector<Command> commands;
+};
+
+// One queue per worker, so staging needs no locks. Committing goes worker by worker, which keeps the result
+// the same from run to run for a given thread count.
+class BodyCommandBuffer {
+public:
+    explicit BodyCommandBuffer(int workers = 1);
+
+    ~BodyCommandBuffer();
+
+    BodyCommandBuffer(const BodyCommandBuffer &) = delete;
+
+    BodyCommandBuffer &operator=(const BodyCommandBuffer &) = delete;
+
+    BodyCommandQueue &queue(int worker) { return queues[worker]; }
+
+    size_t size() const;
+
+    // Applies everything staged since the last commit in one batch. Call on the thread that owns the world,
+    // before b2World::Step and before any staged body is destroyed.
+    void commit();
+
+private:
+    // Before C++17, new and std::allocator ignore alignas beyond the fundamental alignment, so the queues are
+    // placed in over-allocated storage by hand
+    std::unique_ptr<char[]> storage;
+    BodyCommandQueue *queues;
+    int queueCount;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_BODY_COMMANDS_H
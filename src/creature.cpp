@@ -3,22 +3,54 @@
 //
 
 #include "creature.h"
+#include "population_index.h"
 #include <list>
 #include <Box2D/Box2D.h>
-#include <random>
+#include <algorithm>
+#include <cmath>
 
-b2PolygonShape* getRandomPolygonShape(int maxVertices = 5, float maxLength = 2.0f) {
-    std::mt19937 rng(std::time(0));
-    std::uniform_int_distribution<int> vertexCountDistribution(3, maxVertices);
-    std::uniform_real_distribution<float> angleDistribution(0.0f, 2 * b2_pi);
-    std::uniform_real_distribution<float> lengthDistribution(0.0f, maxLength);
+std::atomic<uint32> Creature::nextId(1);
 
-    int vertexCount = vertexCountDistribution(rng);
+Creature::~Creature() {
+    if (index) {
+        index->remove(this);
+    }
+}
+
+void Creature::onHealthChanged(float previousHealth) {
+    index->onHealthChanged(this, previousHealth);
+}
+
+void Creature::onBodyPartAdded() {
+    index->onBodyPartAdded(this);
+}
+
+void Creature::destroy(b2World *world, Creature *creature) {
+    for (b2Body *bodyPart: creature->getBodyParts()) {
+        delete static_cast<BodyData *>(bodyPart->GetUserData());
+        bodyPart->SetUserData(nullptr);
+
+        // Remove all fixtures attached to the body
+        b2Fixture *fixture = bodyPart->GetFixtureList();
+        while (fixture != NULL) {
+            b2Fixture *next = fixture->GetNext();
+            bodyPart->DestroyFixture(fixture);
+            fixture = next;
+        }
+        // Delete the body from the world
+        world->DestroyBody(bodyPart);
+    }
+
+    delete creature;
+}
+
+b2PolygonShape getRandomPolygonShape(const UnitRandom &random, int maxVertices = 5, float maxLength = 2.0f) {
+    int vertexCount = std::min(3 + static_cast<int>(random() * (maxVertices - 2)), maxVertices);
     b2Vec2 vertices[b2_maxPolygonVertices];
 
     for (int i = 0; i < vertexCount; ++i) {
-        float angle = angleDistribution(rng);
-        float length = lengthDistribution(rng);
+        float angle = random() * 2 * b2_pi;
+        float length = random() * maxLength;
         vertices[i].x = length * std::cos(angle);
         vertices[i].y = length * std::sin(angle);
     }
@@ -26,10 +58,10 @@ b2PolygonShape* getRandomPolygonShape(int maxVertices = 5, float maxLength = 2.0
     b2PolygonShape polygon;
     polygon.Set(vertices, vertexCount);
 
-    return &polygon;
+    return polygon;
 }
 
-b2Body* copyBody(const b2Body* sourceBody, b2World* world, float mutationRate) {
+b2Body* copyBody(const b2Body* sourceBody, b2World* world, float mutationRate, const UnitRandom &random) {
     b2BodyDef bodyDef;
     bodyDef.type = sourceBody->GetType();
     bodyDef.position = sourceBody->GetPosition();
@@ -50,44 +82,46 @@ b2Body* copyBody(const b2Body* sourceBody, b2World* world, float mutationRate) {
     for (const b2Fixture *sourceFixture = sourceBody->GetFixtureList(); sourceFixture; sourceFixture = sourceFixture->GetNext()) {
         b2FixtureDef fixtureDef;
         fixtureDef.shape = sourceFixture->GetShape();
-        fixtureDef.friction = std::min(std::max(0.0f, sourceFixture->GetFriction() * (1 + mutationRate * ((float)rand() / RAND_MAX - 0.5f))), 1.0f);
-        fixtureDef.restitution = std::min(std::max(0.0f, sourceFixture->GetRestitution() * (1 + mutationRate * ((float)rand() / RAND_MAX - 0.5f))), 1.0f);
-        fixtureDef.density = std::max(0.0f, sourceFixture->GetDensity() * (1 + mutationRate * ((float)rand() / RAND_MAX - 0.5f)));
+        fixtureDef.friction = std::min(std::max(0.0f, sourceFixture->GetFriction() * (1 + mutationRate * (random() - 0.5f))), 1.0f);
+        fixtureDef.restitution = std::min(std::max(0.0f, sourceFixture->GetRestitution() * (1 + mutationRate * (random() - 0.5f))), 1.0f);
+        fixtureDef.density = std::max(0.0f, sourceFixture->GetDensity() * (1 + mutationRate * (random() - 0.5f)));
         fixtureDef.isSensor = sourceFixture->IsSensor();
         fixtureDef.filter = sourceFixture->GetFilterData();
 
         // Check if fixture shape is a square
+        b2PolygonShape polygonShape; // the mutated copy; the parent keeps its own shape
         if (sourceFixture->GetShape()->GetType() == b2Shape::e_polygon) {
-            auto* polygonShape = (b2PolygonShape*)sourceFixture->GetShape();
+            polygonShape = *(const b2PolygonShape*)sourceFixture->GetShape();
 
             // Mutate the size of the square
-            b2Vec2 vertices[4];
-            for (int i = 0; i < 4; i++) {
-                b2Vec2 vertex = polygonShape->GetVertex(i);
-                vertex *= (1 + mutationRate * ((float)rand() / RAND_MAX - 0.5f));
+            int vertexCount = polygonShape.GetVertexCount();
+            b2Vec2 vertices[b2_maxPolygonVertices];
+            for (int i = 0; i < vertexCount; i++) {
+                b2Vec2 vertex = polygonShape.GetVertex(i);
+                vertex *= (1 + mutationRate * (random() - 0.5f));
                 vertices[i] = vertex;
             }
-            polygonShape->Set(vertices, 4);
+            polygonShape.Set(vertices, vertexCount);
 
-            fixtureDef.shape = polygonShape;
+            fixtureDef.shape = &polygonShape;
         }
 
         newBody->CreateFixture(&fixtureDef);
     }
 
     const float newFixtureProbability = 0.1f; // Adjust this value to control the likelihood of generating a new BodyPart
-    float randomValue = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+    float randomValue = random();
     if (randomValue < newFixtureProbability) {
         // Create a new randomly generated BodyPart
 
         b2FixtureDef fixtureDef;
-        fixtureDef.friction = std::min(std::max(0.0f, (float)rand() / RAND_MAX), 1.0f);
-        fixtureDef.restitution = std::min(std::max(0.0f, (float)rand() / RAND_MAX), 1.0f);
-        fixtureDef.density = std::max(0.0f, (float)rand() / RAND_MAX);
+        fixtureDef.friction = std::min(std::max(0.0f, random()), 1.0f);
+        fixtureDef.restitution = std::min(std::max(0.0f, random()), 1.0f);
+        fixtureDef.density = std::max(0.0f, random());
         fixtureDef.isSensor = false;
 
-        b2PolygonShape* newShape = getRandomPolygonShape(5, 2.0f);
-        fixtureDef.shape = newShape;
+        b2PolygonShape newShape = getRandomPolygonShape(random, 5, 2.0f);
+        fixtureDef.shape = &newShape;
 
         newBody->CreateFixture(&fixtureDef);
     }
@@ -95,15 +129,15 @@ b2Body* copyBody(const b2Body* sourceBody, b2World* world, float mutationRate) {
     return newBody;
 }
 
-Creature* Creature::reproduce(b2World* world, float mutationRate) const  {
+Creature* Creature::reproduce(b2World* world, const UnitRandom &random, float mutationRate) const  {
     std::list<b2Body*> newBodyParts;
 
     // Create a new Creature using the new body parts
     auto* newCreature = new Creature();
-
+    newCreature->parentId = id;
 
     for (const b2Body* sourceBody : getBodyParts()) {
-        b2Body* newBody = copyBody(sourceBody, world, mutationRate);
+        b2Body* newBody = copyBody(sourceBody, world, mutationRate, random);
 
         // Get the source body's user data
         BodyData* sourceUserData = static_cast<BodyData*>(sourceBody->GetUserData());
@@ -124,13 +158,15 @@ Creature* Creature::reproduce(b2World* world, float mutationRate) const  {
     }
 
     const float newBodyPartProbability = 0.1f; // Adjust this value to control the likelihood of generating a new BodyPart
-    float randomValue = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+    float randomValue = random();
     if (randomValue < newBodyPartProbability) {
         // Create a new randomly generated BodyPart
-        b2Body* newBody = Creature::createBodyPart(world, newCreature, 4 * ((float)rand() / RAND_MAX) - 2,
-                                         4 * ((float)rand() / RAND_MAX) - 2,
-                                         2 * ((float)rand() / RAND_MAX),
-                                         2 * ((float)rand() / RAND_MAX));
+        // Drawn one at a time: argument evaluation order is unspecified, which would break reproducibility
+        float x = 4 * random() - 2;
+        float y = 4 * random() - 2;
+        float width = 2 * random();
+        float height = 2 * random();
+        b2Body* newBody = Creature::createBodyPart(world, newCreature, x, y, width, height);
         newCreature->addBodyPart(newBody);
     }
 
@@ -140,8 +176,8 @@ Creature* Creature::reproduce(b2World* world, float mutationRate) const  {
     }
 
     // Mutate the offset values
-    newCreature->offsetX *= (1 + mutationRate * ((float)rand() / RAND_MAX - 0.5f));
-    newCreature->offsetY *= (1 + mutationRate * ((float)rand() / RAND_MAX - 0.5f));
+    newCreature->offsetX *= (1 + mutationRate * (random() - 0.5f));
+    newCreature->offsetY *= (1 + mutationRate * (random() - 0.5f));
 
 
 
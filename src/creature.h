@@ -5,6 +5,8 @@
 #ifndef LIQUIDFUN_EVO_SIM_CREATURE_H
 #define LIQUIDFUN_EVO_SIM_CREATURE_H
 
+#include <atomic>
+#include <functional>
 #include <list>
 #include <Box2D/Dynamics/b2Body.h>
 #include <utility>
@@ -12,10 +14,14 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Box2D.h>
 #include <Box2D/Particle/b2ParticleSystem.h>
-#include <GLFW/glfw3.h>
 #include <vector>
 
 class Creature;
+class CreatureHeap;
+
+// Uniformly distributed floats in [0, 1). Mutation draws from this so a seeded run can be reproduced.
+typedef std::function<float()> UnitRandom;
+class PopulationIndex;
 
 struct BodyData {
     // Color components: red, green, blue, alpha
@@ -28,31 +34,72 @@ struct BodyData {
 
 class Creature {
 private:
+    static std::atomic<uint32> nextId;
+
+    uint32 id; // unique for the lifetime of the process, never reused
+    uint32 parentId; // 0 for creatures that were not born through reproduce
     float health;
     float offsetX; // offset values for reproduction
     float offsetY;
     std::list<b2Body *> bodyParts; // assuming Box2D bodies make up the creature's body
+
+    // Set while the creature is in a PopulationIndex, which needs to hear about health and body part changes.
+    // Each of the index's heaps keeps the creature's position in its own slot.
+    static const int HEAP_SLOTS = 2;
+    PopulationIndex *index = nullptr;
+    size_t heapPositions[HEAP_SLOTS];
+    friend class CreatureHeap;
+    friend class PopulationIndex;
+
+    void onHealthChanged(float previousHealth);
+    void onBodyPartAdded();
 public:
-    Creature(std::list<b2Body *> vector) {
+    Creature(std::list<b2Body *> vector) : id(nextId++), parentId(0), heapPositions() {
         health = 100.0f;
         bodyParts = std::move(vector);
         offsetX = 2.0f;
         offsetY = 2.0f;
     }
 
-    Creature() : health(100.0f), offsetX(2.0f), offsetY(2.0f) {}
+    Creature() : id(nextId++), parentId(0), health(100.0f), offsetX(2.0f), offsetY(2.0f), heapPositions() {}
+
+    ~Creature();
+
+    Creature(const Creature &) = delete;
+
+    Creature &operator=(const Creature &) = delete;
 
-    void setHealth(float h) { health = h; }
+    uint32 getId() const { return id; }
 
-    void addToHealth(float h) { health += h; }
+    uint32 getParentId() const { return parentId; }
+
+    void setHealth(float h) {
+        float previousHealth = health;
+        health = h;
+        if (index) onHealthChanged(previousHealth);
+    }
+
+    void addToHealth(float h) {
+        float previousHealth = health;
+        health += h;
+        if (index) onHealthChanged(previousHealth);
+    }
+
+    // Like addToHealth, but leaves telling the index to the caller, in a batch through
+    // PopulationIndex::onHealthChanged. Safe to call from worker threads as long as each creature is only
+    // touched by one of them.
+    void addToHealthDeferred(float h) { health += h; }
 
     float getHealth() const { return health; }
 
     const std::list<b2Body *> &getBodyParts() const { return bodyParts; }
 
-    void addBodyPart(b2Body *body) { bodyParts.push_back(body); }
+    void addBodyPart(b2Body *body) {
+        bodyParts.push_back(body);
+        if (index) onBodyPartAdded();
+    }
 
-    static b2Body *Creature::createBodyPart(b2World *world, Creature* parentCreature, float x, float y, float width, float height) {
+    static b2Body *createBodyPart(b2World *world, Creature* parentCreature, float x, float y, float width, float height) {
         // Create the body definition
         b2BodyDef bodyDef;
         bodyDef.type = b2_dynamicBody;
@@ -87,7 +134,10 @@ public:
     }
 
 
-    Creature *reproduce(b2World *world, float mutationRate = 0.1) const;
+    Creature *reproduce(b2World *world, const UnitRandom &random, float mutationRate = 0.1) const;
+
+    // Destroys the creature's bodies (and their BodyData) in the world, then the creature itself.
+    static void destroy(b2World *world, Creature *creature);
 
     // Getter and setter functions for offsetX and offsetY
     float getOffsetX() const { return offsetX; }
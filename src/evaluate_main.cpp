@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "evaluation.h"
+#include "genome.h"
+#include "thread_pool.h"
+
+struct EvaluateOptions {
+    std::string designsPath;
+    std::string outputPath; // stdout when empty
+    EvaluationSettings settings;
+    int repeats = 1;
+    int threads = 0;
+};
+
+bool parseEvaluateOptions(int argc, char **argv, EvaluateOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--designs") == 0 && hasValue) {
+            options.designsPath = argv[++i];
+        } else if (strcmp(arg, "--out") == 0 && hasValue) {
+            options.outputPath = argv[++i];
+        } else if (strcmp(arg, "--ticks") == 0 && hasValue) {
+            options.settings.ticks = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--repeats") == 0 && hasValue) {
+            options.repeats = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+            options.settings.seed = static_cast<uint32>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            options.threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--arena-size") == 0 && hasValue) {
+            options.settings.arenaSize = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(arg, "--particles") == 0 && hasValue) {
+            options.settings.minParticleCount = atoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.designsPath.empty();
+}
+
+// Scores a batch of creature designs (see genome.h for the file format) in the standard arena and writes
+// one CSV row per design, in input order.
+int main(int argc, char **argv) {
+    EvaluateOptions options;
+    if (!parseEvaluateOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " --designs FILE [--out FILE] [--ticks N] [--repeats N] [--seed S]"
+                  << " [--threads N] [--arena-size X] [--particles N]" << std::endl;
+        return 1;
+    }
+
+    std::vector<CreatureDesign> designs;
+    if (!readDesigns(options.designsPath, designs)) {
+        return 1;
+    }
+
+    ThreadPool pool(options.threads);
+    std::vector<EvaluationResult> results;
+
+    auto start = std::chrono::steady_clock::now();
+    evaluateDesigns(designs, options.settings, options.repeats, pool, results);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::ofstream file;
+    if (!options.outputPath.empty()) {
+        file.open(options.outputPath);
+        if (!file) {
+            std::cerr << "Failed to open output file: " << options.outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = options.outputPath.empty() ? std::cout : file;
+
+    out << "name,energy_gathered,final_health,survived_ticks,distance\n";
+    for (size_t i = 0; i < designs.size(); ++i) {
+        const EvaluationResult &result = results[i];
+        out << designs[i].name << "," << result.energyGathered << "," << result.finalHealth << ","
+            << result.survivedTicks << "," << result.distance << "\n";
+    }
+    out.flush();
+
+    size_t episodes = designs.size() * static_cast<size_t>(std::max(1, options.repeats));
+    std::cerr << "Evaluated " << episodes << " episodes of " << options.settings.ticks << " ticks on "
+              << pool.size() << " threads in " << elapsed.count() << " s ("
+              << (elapsed.count() > 0.0 ? episodes * 60.0 / elapsed.count() : 0.0) << " per minute)" << std::endl;
+
+    return out ? 0 : 1;
+}
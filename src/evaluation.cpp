@@ -0,0 +1,83 @@
+#include "evaluation.h"
+#include "simulation.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // The standard arena: no drawing or bookkeeping, and feeding that totals the energy handed out
+    struct ArenaConfig {
+        typedef NullRenderer Renderer;
+        typedef CountingParticleFood Food;
+        typedef RandomForceLocomotion Locomotion;
+        typedef std::mt19937 Rng;
+        typedef NoInstrumentation Instrumentation;
+    };
+}
+
+EvaluationResult evaluateDesign(const CreatureDesign &design, const EvaluationSettings &settings, uint32 seed) {
+    SimulationParams params;
+    params.worldSize = settings.arenaSize;
+    params.minParticleCount = settings.minParticleCount;
+    params.feedAmount = settings.feedAmount;
+    params.metabolism = settings.metabolism;
+    params.forceMagnitude = settings.forceMagnitude;
+    params.reproductionThreshold = std::numeric_limits<float>::infinity();
+    params.particleBlockSize = settings.particleBlockSize;
+    params.particleBlockPosition.Set(settings.arenaSize / 2.0f, settings.particleBlockSize / 2.0f + 0.5f);
+    params.starterCreatures = false;
+    params.seed = seed;
+
+    Simulation<ArenaConfig> simulation(params);
+    b2Vec2 origin(settings.arenaSize / 2.0f, settings.arenaSize / 2.0f);
+    Creature *creature = buildCreature(&simulation.getWorld(), design, origin);
+    simulation.addCreature(creature);
+    b2Vec2 start = creature->getBodyParts().front()->GetPosition();
+    b2Vec2 end = start;
+
+    // The death sweep destroys the creature, so its position is read after every tick it survives
+    bool alive = true;
+    while (alive && simulation.getTick() < settings.ticks) {
+        simulation.step();
+        alive = !simulation.getCreatures().empty();
+        if (alive) {
+            end = creature->getBodyParts().front()->GetPosition();
+        }
+    }
+
+    EvaluationResult result;
+    result.energyGathered = simulation.getFood().getEnergyGiven();
+    result.finalHealth = alive ? creature->getHealth() : 0.0f;
+    result.survivedTicks = static_cast<float>(simulation.getTick());
+    result.distance = (end - start).Length();
+    return result;
+}
+
+void evaluateDesigns(const std::vector<CreatureDesign> &designs, const EvaluationSettings &settings, int repeats,
+                     ThreadPool &pool, std::vector<EvaluationResult> &results) {
+    repeats = std::max(1, repeats);
+    results.assign(designs.size(), EvaluationResult());
+
+    prepareWorldsForThreads();
+
+    std::vector<EvaluationResult> episodes(designs.size() * repeats);
+    pool.parallelForEach(static_cast<int>(episodes.size()), [&](int episode, int) {
+        int repeat = episode % repeats;
+        episodes[episode] = evaluateDesign(designs[episode / repeats], settings, deriveSeed(settings.seed, static_cast<uint32>(repeat)));
+    });
+
+    for (size_t i = 0; i < designs.size(); ++i) {
+        EvaluationResult &total = results[i];
+        for (int repeat = 0; repeat < repeats; ++repeat) {
+            const EvaluationResult &episode = episodes[i * repeats + repeat];
+            total.energyGathered += episode.energyGathered;
+            total.finalHealth += episode.finalHealth;
+            total.survivedTicks += episode.survivedTicks;
+            total.distance += episode.distance;
+        }
+        float scale = 1.0f / static_cast<float>(repeats);
+        total.energyGathered *= scale;
+        total.finalHealth *= scale;
+        total.survivedTicks *= scale;
+        total.distance *= scale;
+    }
+}
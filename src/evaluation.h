@@ -0,0 +1,40 @@
+#ifndef LIQUIDFUN_EVO_SIM_EVALUATION_H
+#define LIQUIDFUN_EVO_SIM_EVALUATION_H
+
+#include <Box2D/Box2D.h>
+#include <vector>
+#include "genome.h"
+#include "thread_pool.h"
+
+// Standard arena every design is scored in: a Simulation in a small walled square with a block of water
+// particles that is topped back up to minParticleCount, so feeding, metabolism and locomotion follow the same
+// rules as every other run. Reproduction is off, so a design is judged on its own.
+struct EvaluationSettings {
+    unsigned long ticks = 10000;
+    float arenaSize = 20.0f;
+    float particleBlockSize = 4.0f; // side of the water block placed at the start
+    int32 minParticleCount = 300;
+    float feedAmount = 0.01f;
+    float metabolism = 0.02f;
+    float forceMagnitude = 1.0f;
+    uint32 seed = 1;
+};
+
+struct EvaluationResult {
+    float energyGathered = 0.0f; // fitness: total health gained from feeding
+    float finalHealth = 0.0f; // 0 if the creature died
+    float survivedTicks = 0.0f;
+    float distance = 0.0f; // how far the first body part ended up from where it started
+};
+
+// Runs one episode in a private Simulation. The same seed gives the same particle spawns and forces; 0 seeds
+// from the clock.
+EvaluationResult evaluateDesign(const CreatureDesign &design, const EvaluationSettings &settings, uint32 seed);
+
+// Scores every design `repeats` times and averages the results into results[i]. Every design sees the same
+// set of seeds so differences come from the designs, not the luck of the draw. Episodes are spread over
+// the pool with work stealing since creatures that die early finish long before the rest.
+void evaluateDesigns(const std::vector<CreatureDesign> &designs, const EvaluationSettings &settings, int repeats,
+                     ThreadPool &pool, std::vector<EvaluationResult> &results);
+
+#endif //LIQUIDFUN_EVO_SIM_EVALUATION_H
@@ -0,0 +1,145 @@
+#include "eviction.h"
+#include "memory_accounting.h"
+#include <algorithm>
+#include <cstring>
+
+bool parseEvictionPolicy(const char *name, EvictionPolicy &policy) {
+    if (strcmp(name, "lowest-health") == 0) {
+        policy = EvictionPolicy::LowestHealthFirst;
+    } else if (strcmp(name, "oldest") == 0) {
+        policy = EvictionPolicy::OldestFirst;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool lowerHealthFirst(const Creature *a, const Creature *b) {
+    if (a->getHealth() != b->getHealth()) {
+        return a->getHealth() < b->getHealth();
+    }
+    return olderFirst(a, b);
+}
+
+bool higherHealthFirst(const Creature *a, const Creature *b) {
+    if (a->getHealth() != b->getHealth()) {
+        return a->getHealth() > b->getHealth();
+    }
+    return olderFirst(a, b);
+}
+
+bool olderFirst(const Creature *a, const Creature *b) {
+    // Ids increase with birth order
+    return a->getId() < b->getId();
+}
+
+CreatureOrder evictionOrder(EvictionPolicy policy) {
+    return policy == EvictionPolicy::OldestFirst ? olderFirst : lowerHealthFirst;
+}
+
+bool CreatureHeap::contains(const Creature *creature) const {
+    size_t position = creature->heapPositions[slot];
+    return position < items.size() && items[position] == creature;
+}
+
+void CreatureHeap::push(Creature *creature) {
+    items.push_back(creature);
+    creature->heapPositions[slot] = items.size() - 1;
+    siftUp(items.size() - 1);
+}
+
+Creature *CreatureHeap::pop() {
+    Creature *first = top();
+    if (first) {
+        remove(first);
+    }
+    return first;
+}
+
+void CreatureHeap::remove(Creature *creature) {
+    if (!contains(creature)) {
+        return;
+    }
+
+    size_t position = creature->heapPositions[slot];
+    Creature *last = items.back();
+    items.pop_back();
+
+    if (last != creature) {
+        place(position, last);
+        siftUp(position);
+        siftDown(last->heapPositions[slot]);
+    }
+}
+
+void CreatureHeap::update(Creature *creature) {
+    if (!contains(creature)) {
+        return;
+    }
+    siftUp(creature->heapPositions[slot]);
+    siftDown(creature->heapPositions[slot]);
+}
+
+void CreatureHeap::rebuild() {
+    for (size_t position = items.size() / 2; position-- > 0;) {
+        siftDown(position);
+    }
+}
+
+void CreatureHeap::place(size_t position, Creature *creature) {
+    items[position] = creature;
+    creature->heapPositions[slot] = position;
+}
+
+void CreatureHeap::siftUp(size_t position) {
+    Creature *creature = items[position];
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        if (!order(creature, items[parent])) {
+            break;
+        }
+        place(position, items[parent]);
+        position = parent;
+    }
+    place(position, creature);
+}
+
+void CreatureHeap::siftDown(size_t position) {
+    Creature *creature = items[position];
+    size_t count = items.size();
+    while (true) {
+        size_t child = position * 2 + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && order(items[child + 1], items[child])) {
+            ++child;
+        }
+        if (!order(items[child], creature)) {
+            break;
+        }
+        place(position, items[child]);
+        position = child;
+    }
+    place(position, creature);
+}
+
+size_t enforcePopulationBudget(const PopulationBudget &budget, CreatureHeap &heap, size_t population,
+                               size_t creatureBytes) {
+    size_t evicted = 0;
+
+    while ((budget.maxPopulation != 0 && population > budget.maxPopulation) ||
+           (budget.maxBytes != 0 && creatureBytes > budget.maxBytes)) {
+        Creature *victim = heap.pop();
+        if (!victim) {
+            break;
+        }
+
+        creatureBytes -= std::min(creatureBytes, measureCreature(victim).totalBytes());
+        victim->setHealth(0.0f);
+        --population;
+        ++evicted;
+    }
+
+    return evicted;
+}
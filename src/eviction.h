@@ -0,0 +1,94 @@
+#ifndef LIQUIDFUN_EVO_SIM_EVICTION_H
+#define LIQUIDFUN_EVO_SIM_EVICTION_H
+
+#include <cstddef>
+#include <vector>
+#include "creature.h"
+
+enum class EvictionPolicy {
+    LowestHealthFirst,
+    OldestFirst
+};
+
+// Accepts "lowest-health" and "oldest".
+bool parseEvictionPolicy(const char *name, EvictionPolicy &policy);
+
+// Ordering for eviction: true if `a` should go before `b`.
+typedef bool (*CreatureOrder)(const Creature *a, const Creature *b);
+
+CreatureOrder evictionOrder(EvictionPolicy policy);
+
+// Lowest health first, oldest first on ties
+bool lowerHealthFirst(const Creature *a, const Creature *b);
+
+// Highest health first, oldest first on ties
+bool higherHealthFirst(const Creature *a, const Creature *b);
+
+// Lowest id first, i.e. birth order
+bool olderFirst(const Creature *a, const Creature *b);
+
+// Indexed binary heap of creatures. Each creature remembers its position in one of its heap slots, so a
+// key change re-sifts just that entry and removal is O(log n) without a search. Heaps sharing creatures
+// must use different slots.
+class CreatureHeap {
+public:
+    CreatureHeap(CreatureOrder order, int slot) : order(order), slot(slot) {}
+
+    CreatureHeap(const CreatureHeap &) = delete;
+
+    CreatureHeap &operator=(const CreatureHeap &) = delete;
+
+    size_t size() const { return items.size(); }
+
+    bool empty() const { return items.empty(); }
+
+    bool contains(const Creature *creature) const;
+
+    void push(Creature *creature);
+
+    // First creature in order, or nullptr if empty
+    Creature *top() const { return items.empty() ? nullptr : items.front(); }
+
+    Creature *pop();
+
+    void remove(Creature *creature);
+
+    // Restores heap order after the creature's key changed
+    void update(Creature *creature);
+
+    // Restores heap order after many keys changed at once. O(n), however many entries moved.
+    void rebuild();
+
+    // Heap array access for walking the first entries without popping: the children of `position` are
+    // 2 * position + 1 and 2 * position + 2.
+    Creature *at(size_t position) const { return items[position]; }
+
+    bool before(const Creature *a, const Creature *b) const { return order(a, b); }
+
+private:
+    void place(size_t position, Creature *creature);
+
+    void siftUp(size_t position);
+
+    void siftDown(size_t position);
+
+    CreatureOrder order;
+    int slot;
+    std::vector<Creature *> items;
+};
+
+// Limits on the population; 0 means unlimited.
+struct PopulationBudget {
+    size_t maxPopulation = 0;
+    size_t maxBytes = 0; // creature memory only; particles and contacts cannot be evicted
+
+    bool isLimited() const { return maxPopulation != 0 || maxBytes != 0; }
+};
+
+// Pops creatures off the heap until `population` and `creatureBytes` (MemoryCounters::creatureTotalBytes)
+// fit the budget. Evicted creatures get their health set to 0 and are removed by the regular dead-creature
+// sweep. Returns how many were evicted.
+size_t enforcePopulationBudget(const PopulationBudget &budget, CreatureHeap &heap, size_t population,
+                               size_t creatureBytes);
+
+#endif //LIQUIDFUN_EVO_SIM_EVICTION_H
@@ -0,0 +1,215 @@
+#include "fluid_density.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLUID_DENSITY_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // 5-tap binomial approximation of a Gaussian: 1 4 6 4 1
+    const float blurWeights[5] = {1.0f / 16.0f, 4.0f / 16.0f, 6.0f / 16.0f, 4.0f / 16.0f, 1.0f / 16.0f};
+
+    inline void splatCell(float *grid, int width, int cellX, int cellY, float fracX, float fracY) {
+        float *row = grid + cellY * width + cellX;
+        row[0] += (1.0f - fracX) * (1.0f - fracY);
+        row[1] += fracX * (1.0f - fracY);
+        row[width] += (1.0f - fracX) * fracY;
+        row[width + 1] += fracX * fracY;
+    }
+
+    inline float smoothStep(float edge0, float edge1, float x) {
+        float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+}
+
+FluidDensityGrid::FluidDensityGrid(int width, int height, float worldSize)
+        : width(std::max(2, width)), height(std::max(2, height)),
+          cellsPerUnitX(static_cast<float>(std::max(2, width)) / worldSize),
+          cellsPerUnitY(static_cast<float>(std::max(2, height)) / worldSize),
+          density(static_cast<size_t>(std::max(2, width)) * std::max(2, height), 0.0f),
+          scratch(density.size(), 0.0f) {}
+
+void FluidDensityGrid::splat(const b2Vec2 *positions, int particleCount, ThreadPool &pool) {
+    // Partial grids are zeroed by the reduction below, so they only need clearing when first allocated
+    if (static_cast<int>(partialGrids.size()) != pool.size()) {
+        partialGrids.assign(pool.size(), std::vector<float>(density.size(), 0.0f));
+    }
+
+    // Bilinear splatting touches (x, y) and (x + 1, y + 1), so keep the base cell one short of the edge
+    const float maxCellX = static_cast<float>(width) - 1.001f;
+    const float maxCellY = static_cast<float>(height) - 1.001f;
+
+    pool.parallelFor(particleCount, [&](int begin, int end, int worker) {
+        float *grid = partialGrids[worker].data();
+        int i = begin;
+
+#ifdef FLUID_DENSITY_SSE2
+        const __m128 scaleX = _mm_set1_ps(cellsPerUnitX);
+        const __m128 scaleY = _mm_set1_ps(cellsPerUnitY);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 limitX = _mm_set1_ps(maxCellX);
+        const __m128 limitY = _mm_set1_ps(maxCellY);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        const __m128 largest = _mm_set1_ps(FLT_MAX);
+
+        alignas(16) int cellX[4];
+        alignas(16) int cellY[4];
+        alignas(16) float fracX[4];
+        alignas(16) float fracY[4];
+
+        // Four particles at a time: de-interleave x/y, map to cell space and split into cell + fraction
+        for (; i + 4 <= end; i += 4) {
+            const float *source = &positions[i].x;
+            __m128 xy01 = _mm_loadu_ps(source);
+            __m128 xy23 = _mm_loadu_ps(source + 4);
+            __m128 x = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 y = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 1, 3, 1));
+
+            // Lanes with a NaN or infinite coordinate are skipped like in the scalar loop, instead of being
+            // clamped into an edge cell. |v| <= FLT_MAX is false for both.
+            int finiteLanes = _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(_mm_and_ps(x, absMask), largest),
+                                                         _mm_cmple_ps(_mm_and_ps(y, absMask), largest)));
+
+            x = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(x, scaleX), half), zero), limitX);
+            y = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(y, scaleY), half), zero), limitY);
+
+            // Values are non-negative here, so truncation is the same as floor
+            __m128i ix = _mm_cvttps_epi32(x);
+            __m128i iy = _mm_cvttps_epi32(y);
+
+            _mm_store_si128(reinterpret_cast<__m128i *>(cellX), ix);
+            _mm_store_si128(reinterpret_cast<__m128i *>(cellY), iy);
+            _mm_store_ps(fracX, _mm_sub_ps(x, _mm_cvtepi32_ps(ix)));
+            _mm_store_ps(fracY, _mm_sub_ps(y, _mm_cvtepi32_ps(iy)));
+
+            for (int lane = 0; lane < 4; ++lane) {
+                if (finiteLanes & (1 << lane)) {
+                    splatCell(grid, width, cellX[lane], cellY[lane], fracX[lane], fracY[lane]);
+                }
+            }
+        }
+#endif
+
+        for (; i < end; ++i) {
+            // std::max passes NaN through, and casting it to int is undefined
+            if (!std::isfinite(positions[i].x) || !std::isfinite(positions[i].y)) {
+                continue;
+            }
+            float x = std::min(std::max(positions[i].x * cellsPerUnitX - 0.5f, 0.0f), maxCellX);
+            float y = std::min(std::max(positions[i].y * cellsPerUnitY - 0.5f, 0.0f), maxCellY);
+            int ix = static_cast<int>(x);
+            int iy = static_cast<int>(y);
+            splatCell(grid, width, ix, iy, x - static_cast<float>(ix), y - static_cast<float>(iy));
+        }
+    });
+
+    // Sum the per-thread grids into the density field, clearing them for the next frame as we go
+    const int gridCount = static_cast<int>(partialGrids.size());
+    pool.parallelFor(height, [&](int beginRow, int endRow, int) {
+        int begin = beginRow * width;
+        int end = endRow * width;
+        int i = begin;
+
+#ifdef FLUID_DENSITY_SSE2
+        for (; i + 4 <= end; i += 4) {
+            __m128 sum = _mm_setzero_ps();
+            for (int g = 0; g < gridCount; ++g) {
+                float *partial = partialGrids[g].data() + i;
+                sum = _mm_add_ps(sum, _mm_loadu_ps(partial));
+                _mm_storeu_ps(partial, _mm_setzero_ps());
+            }
+            _mm_storeu_ps(density.data() + i, sum);
+        }
+#endif
+
+        for (; i < end; ++i) {
+            float sum = 0.0f;
+            for (int g = 0; g < gridCount; ++g) {
+                sum += partialGrids[g][i];
+                partialGrids[g][i] = 0.0f;
+            }
+            density[i] = sum;
+        }
+    });
+}
+
+void FluidDensityGrid::blur(ThreadPool &pool, int passes) {
+    for (int pass = 0; pass < passes; ++pass) {
+        // Horizontal: density -> scratch
+        pool.parallelFor(height, [&](int beginRow, int endRow, int) {
+            for (int y = beginRow; y < endRow; ++y) {
+                const float *in = density.data() + y * width;
+                float *out = scratch.data() + y * width;
+                for (int x = 0; x < width; ++x) {
+                    float sum = 0.0f;
+                    for (int k = -2; k <= 2; ++k) {
+                        int sampleX = std::min(std::max(x + k, 0), width - 1);
+                        sum += blurWeights[k + 2] * in[sampleX];
+                    }
+                    out[x] = sum;
+                }
+            }
+        });
+
+        // Vertical: scratch -> density. Neighbouring rows are contiguous, so this runs four columns per step
+        pool.parallelFor(height, [&](int beginRow, int endRow, int) {
+            for (int y = beginRow; y < endRow; ++y) {
+                const float *rows[5];
+                for (int k = -2; k <= 2; ++k) {
+                    rows[k + 2] = scratch.data() + std::min(std::max(y + k, 0), height - 1) * width;
+                }
+                float *out = density.data() + y * width;
+                int x = 0;
+
+#ifdef FLUID_DENSITY_SSE2
+                const __m128 w0 = _mm_set1_ps(blurWeights[0]);
+                const __m128 w1 = _mm_set1_ps(blurWeights[1]);
+                const __m128 w2 = _mm_set1_ps(blurWeights[2]);
+                for (; x + 4 <= width; x += 4) {
+                    __m128 sum = _mm_mul_ps(w0, _mm_add_ps(_mm_loadu_ps(rows[0] + x), _mm_loadu_ps(rows[4] + x)));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(w1, _mm_add_ps(_mm_loadu_ps(rows[1] + x),
+                                                                    _mm_loadu_ps(rows[3] + x))));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(w2, _mm_loadu_ps(rows[2] + x)));
+                    _mm_storeu_ps(out + x, sum);
+                }
+#endif
+
+                for (; x < width; ++x) {
+                    out[x] = blurWeights[0] * (rows[0][x] + rows[4][x]) +
+                             blurWeights[1] * (rows[1][x] + rows[3][x]) +
+                             blurWeights[2] * rows[2][x];
+                }
+            }
+        });
+    }
+}
+
+void FluidDensityGrid::toRGBA(std::vector<uint8_t> &pixels, float threshold, ThreadPool &pool) const {
+    pixels.resize(density.size() * 4);
+
+    pool.parallelFor(static_cast<int>(density.size()), [&](int begin, int end, int) {
+        for (int i = begin; i < end; ++i) {
+            float d = density[i];
+
+            // Soft edge around the threshold, deeper blue as the fluid gets denser
+            float coverage = smoothStep(0.5f * threshold, threshold, d);
+            float depth = std::min(d / (3.0f * threshold), 1.0f);
+            float rim = 4.0f * coverage * (1.0f - coverage);
+
+            float r = 0.35f - 0.27f * depth + 0.35f * rim;
+            float g = 0.67f - 0.40f * depth + 0.30f * rim;
+            float b = 1.00f - 0.20f * depth;
+
+            uint8_t *pixel = &pixels[static_cast<size_t>(i) * 4];
+            pixel[0] = static_cast<uint8_t>(std::min(r, 1.0f) * 255.0f);
+            pixel[1] = static_cast<uint8_t>(std::min(g, 1.0f) * 255.0f);
+            pixel[2] = static_cast<uint8_t>(std::min(b, 1.0f) * 255.0f);
+            pixel[3] = static_cast<uint8_t>(coverage * 0.9f * 255.0f);
+        }
+    });
+}
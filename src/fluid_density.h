@@ -0,0 +1,42 @@
+#ifndef LIQUIDFUN_EVO_SIM_FLUID_DENSITY_H
+#define LIQUIDFUN_EVO_SIM_FLUID_DENSITY_H
+
+#include <Box2D/Box2D.h>
+#include <cstdint>
+#include <vector>
+#include "thread_pool.h"
+
+// Low resolution density field of the particle system. Particles are splatted into the grid on the CPU,
+// blurred, and turned into an RGBA image so the renderer can draw the whole fluid as one textured quad.
+class FluidDensityGrid {
+public:
+    FluidDensityGrid(int width, int height, float worldSize);
+
+    int getWidth() const { return width; }
+
+    int getHeight() const { return height; }
+
+    // Bilinearly splats every particle position into the grid. Each thread fills its own partial grid,
+    // which are then summed together, so no atomics are needed.
+    void splat(const b2Vec2 *positions, int particleCount, ThreadPool &pool);
+
+    // Separable 5-tap Gaussian blur, applied `passes` times.
+    void blur(ThreadPool &pool, int passes = 2);
+
+    // Maps density to a water colour. Cells below `threshold` fade out so the fluid gets a soft surface.
+    void toRGBA(std::vector<uint8_t> &pixels, float threshold, ThreadPool &pool) const;
+
+    const std::vector<float> &getDensity() const { return density; }
+
+private:
+    int width;
+    int height;
+    float cellsPerUnitX;
+    float cellsPerUnitY;
+
+    std::vector<float> density;
+    std::vector<float> scratch;
+    std::vector<std::vector<float>> partialGrids;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_FLUID_DENSITY_H
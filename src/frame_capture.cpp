@@ -0,0 +1,84 @@
+#include "frame_capture.h"
+#include "image_writer.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+FrameCapture::FrameCapture(std::string directory, unsigned long interval, int width, int height,
+                           CaptureFormat format)
+        : directory(std::move(directory)), interval(interval == 0 ? 1 : interval), width(width), height(height),
+          format(format), stopping(false), framesWritten(0), framesDropped(0) {
+    // Started last so every member is initialized before the thread can touch it
+    writerThread = std::thread(&FrameCapture::writerLoop, this);
+}
+
+FrameCapture::~FrameCapture() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    frameReady.notify_one();
+    writerThread.join();
+
+    if (framesDropped > 0) {
+        std::cerr << "Frame capture dropped " << framesDropped << " frames" << std::endl;
+    }
+}
+
+void FrameCapture::captureIfDue(unsigned long tick, const std::list<Creature *> &creatureList,
+                                b2ParticleSystem *particleSystem, float worldSize) {
+    if (tick % interval != 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pendingFrames.size() >= MAX_PENDING_FRAMES) {
+            ++framesDropped;
+            return;
+        }
+    }
+
+    std::unique_ptr<WorldSnapshot> snapshot(new WorldSnapshot());
+    captureWorldSnapshot(creatureList, particleSystem, worldSize, tick, *snapshot);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingFrames.push_back(std::move(snapshot));
+    }
+    frameReady.notify_one();
+}
+
+void FrameCapture::writerLoop() {
+    // Shares the simulation's pool; while the simulation has it busy, frames rasterize on this thread alone
+    SoftwareRenderer renderer(width, height, sharedThreadPool());
+    const char *extension = format == CaptureFormat::PNG ? "png" : "ppm";
+
+    while (true) {
+        std::unique_ptr<WorldSnapshot> snapshot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameReady.wait(lock, [this] { return stopping || !pendingFrames.empty(); });
+            if (pendingFrames.empty()) {
+                return;
+            }
+            snapshot = std::move(pendingFrames.front());
+            pendingFrames.pop_front();
+        }
+
+        renderer.render(*snapshot);
+
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "/frame_%08lu.%s", snapshot->tick, extension);
+        std::string path = directory + fileName;
+
+        bool written = format == CaptureFormat::PNG
+                       ? writePNG(path, renderer.getPixels().data(), width, height)
+                       : writePPM(path, renderer.getPixels().data(), width, height);
+        if (written) {
+            ++framesWritten;
+        } else {
+            std::cerr << "Failed to write frame " << path << std::endl;
+        }
+    }
+}
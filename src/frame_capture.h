@@ -0,0 +1,62 @@
+#ifndef LIQUIDFUN_EVO_SIM_FRAME_CAPTURE_H
+#define LIQUIDFUN_EVO_SIM_FRAME_CAPTURE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "software_renderer.h"
+#include "world_snapshot.h"
+
+enum class CaptureFormat {
+    PNG,
+    PPM
+};
+
+// Writes an image of the world every `interval` ticks without needing a GL context. The simulation thread
+// only copies a WorldSnapshot; rasterizing and encoding happen on a background thread. If that thread falls
+// behind, new frames are dropped rather than stalling the simulation.
+class FrameCapture {
+public:
+    FrameCapture(std::string directory, unsigned long interval, int width, int height, CaptureFormat format);
+
+    // Flushes every queued frame before returning.
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture &) = delete;
+
+    FrameCapture &operator=(const FrameCapture &) = delete;
+
+    void captureIfDue(unsigned long tick, const std::list<Creature *> &creatureList,
+                      b2ParticleSystem *particleSystem, float worldSize);
+
+    unsigned long getFramesWritten() const { return framesWritten; }
+
+    unsigned long getFramesDropped() const { return framesDropped; }
+
+private:
+    void writerLoop();
+
+    static const size_t MAX_PENDING_FRAMES = 4;
+
+    std::string directory;
+    unsigned long interval;
+    int width;
+    int height;
+    CaptureFormat format;
+
+    std::mutex mutex;
+    std::condition_variable frameReady;
+    std::deque<std::unique_ptr<WorldSnapshot>> pendingFrames;
+    bool stopping;
+
+    std::atomic<unsigned long> framesWritten;
+    std::atomic<unsigned long> framesDropped;
+
+    std::thread writerThread;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_FRAME_CAPTURE_H
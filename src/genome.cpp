@@ -0,0 +1,274 @@
+#include "genome.h"
+#include "parse_error.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+    const uint64_t FNV_PRIME = 1099511628211ull;
+
+    void hashFloat(uint64_t &hash, float value) {
+        // -0 and 0 are the same trait
+        if (value == 0.0f) {
+            value = 0.0f;
+        }
+        unsigned char bytes[sizeof(float)];
+        memcpy(bytes, &value, sizeof(float));
+        for (unsigned char byte: bytes) {
+            hash = (hash ^ byte) * FNV_PRIME;
+        }
+    }
+
+    // Box2D asserts on polygons it cannot build a hull from, so reject them while reading
+    bool validPolygon(const FixtureDesign &fixture) {
+        if (fixture.vertexCount < 3 || fixture.vertexCount > b2_maxPolygonVertices) {
+            return false;
+        }
+        float area = 0.0f;
+        for (int i = 0; i < fixture.vertexCount; ++i) {
+            const b2Vec2 &a = fixture.vertices[i];
+            const b2Vec2 &b = fixture.vertices[(i + 1) % fixture.vertexCount];
+            area += a.x * b.y - a.y * b.x;
+        }
+        return std::abs(area) > 4.0f * b2_epsilon;
+    }
+}
+
+bool readDesigns(const std::string &path, std::vector<CreatureDesign> &designs) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open design file: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    bool inCreature = false;
+    CreatureDesign design;
+
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream in(line);
+        std::string directive;
+        if (!(in >> directive)) {
+            continue;
+        }
+
+        if (directive == "creature") {
+            if (inCreature) {
+                return parseError(path, lineNumber, "missing 'end' before 'creature'");
+            }
+            design = CreatureDesign();
+            if (!(in >> design.name >> design.offsetX >> design.offsetY)) {
+                return parseError(path, lineNumber, "expected: creature NAME OFFSET_X OFFSET_Y");
+            }
+            inCreature = true;
+        } else if (!inCreature) {
+            return parseError(path, lineNumber, "expected 'creature'");
+        } else if (directive == "part") {
+            BodyPartDesign part;
+            if (!(in >> part.position.x >> part.position.y >> part.angle >> part.r >> part.g >> part.b)) {
+                return parseError(path, lineNumber, "expected: part X Y ANGLE R G B");
+            }
+            design.parts.push_back(part);
+        } else if (directive == "box" || directive == "polygon") {
+            if (design.parts.empty()) {
+                return parseError(path, lineNumber, "fixture before any 'part'");
+            }
+
+            FixtureDesign fixture;
+            if (directive == "box") {
+                float width, height;
+                if (!(in >> width >> height)) {
+                    return parseError(path, lineNumber, "expected: box WIDTH HEIGHT [DENSITY FRICTION RESTITUTION]");
+                }
+                // Optional material; keep the defaults createBodyPart uses when it is left out
+                float density, friction, restitution;
+                if (in >> density >> friction >> restitution) {
+                    fixture.density = density;
+                    fixture.friction = friction;
+                    fixture.restitution = restitution;
+                }
+                fixture.vertexCount = 4;
+                fixture.vertices[0].Set(-width / 2.0f, -height / 2.0f);
+                fixture.vertices[1].Set(width / 2.0f, -height / 2.0f);
+                fixture.vertices[2].Set(width / 2.0f, height / 2.0f);
+                fixture.vertices[3].Set(-width / 2.0f, height / 2.0f);
+            } else {
+                if (!(in >> fixture.density >> fixture.friction >> fixture.restitution >> fixture.vertexCount) ||
+                    fixture.vertexCount < 3 || fixture.vertexCount > b2_maxPolygonVertices) {
+                    return parseError(path, lineNumber, "expected: polygon DENSITY FRICTION RESTITUTION N X1 Y1 ...");
+                }
+                for (int i = 0; i < fixture.vertexCount; ++i) {
+                    if (!(in >> fixture.vertices[i].x >> fixture.vertices[i].y)) {
+                        return parseError(path, lineNumber, "too few polygon vertices");
+                    }
+                }
+            }
+
+            if (!validPolygon(fixture)) {
+                return parseError(path, lineNumber, "degenerate polygon");
+            }
+            design.parts.back().fixtures.push_back(fixture);
+        } else if (directive == "end") {
+            if (design.parts.empty()) {
+                return parseError(path, lineNumber, "creature has no parts");
+            }
+            designs.push_back(design);
+            inCreature = false;
+        } else {
+            return parseError(path, lineNumber, "unknown directive");
+        }
+    }
+
+    if (inCreature) {
+        return parseError(path, lineNumber, "missing 'end' at end of file");
+    }
+    return true;
+}
+
+bool writeDesigns(const std::string &path, const std::vector<CreatureDesign> &designs) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open design file for writing: " << path << std::endl;
+        return false;
+    }
+
+    file.precision(9);
+    for (const CreatureDesign &design: designs) {
+        file << "creature " << design.name << " " << design.offsetX << " " << design.offsetY << "\n";
+        for (const BodyPartDesign &part: design.parts) {
+            file << "part " << part.position.x << " " << part.position.y << " " << part.angle << " "
+                 << part.r << " " << part.g << " " << part.b << "\n";
+            for (const FixtureDesign &fixture: part.fixtures) {
+                file << "polygon " << fixture.density << " " << fixture.friction << " " << fixture.restitution
+                     << " " << fixture.vertexCount;
+                for (int i = 0; i < fixture.vertexCount; ++i) {
+                    file << " " << fixture.vertices[i].x << " " << fixture.vertices[i].y;
+                }
+                file << "\n";
+            }
+        }
+        file << "end\n";
+    }
+
+    return static_cast<bool>(file);
+}
+
+Creature *buildCreature(b2World *world, const CreatureDesign &design, const b2Vec2 &origin) {
+    auto *creature = new Creature();
+    creature->setOffsetX(design.offsetX);
+    creature->setOffsetY(design.offsetY);
+
+    for (const BodyPartDesign &part: design.parts) {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position = origin + part.position;
+        bodyDef.angle = part.angle;
+        b2Body *body = world->CreateBody(&bodyDef);
+
+        for (const FixtureDesign &fixture: part.fixtures) {
+            b2PolygonShape shape;
+            shape.Set(fixture.vertices, fixture.vertexCount);
+
+            b2FixtureDef fixtureDef;
+            fixtureDef.shape = &shape;
+            fixtureDef.density = fixture.density;
+            fixtureDef.friction = fixture.friction;
+            fixtureDef.restitution = fixture.restitution;
+            body->CreateFixture(&fixtureDef);
+        }
+
+        auto *bodyData = new BodyData(part.r, part.g, part.b, 1.0f);
+        bodyData->parentCreature = creature;
+        body->SetUserData(bodyData);
+
+        creature->addBodyPart(body);
+    }
+
+    return creature;
+}
+
+CreatureDesign describeCreature(const Creature *creature, const std::string &name) {
+    CreatureDesign design;
+    design.name = name;
+    design.offsetX = creature->getOffsetX();
+    design.offsetY = creature->getOffsetY();
+
+    const std::list<b2Body *> &bodyParts = creature->getBodyParts();
+    b2Vec2 origin = bodyParts.empty() ? b2Vec2(0.0f, 0.0f) : bodyParts.front()->GetPosition();
+
+    for (const b2Body *body: bodyParts) {
+        BodyPartDesign part;
+        part.position = body->GetPosition() - origin;
+        part.angle = body->GetAngle();
+
+        auto *bodyData = static_cast<const BodyData *>(body->GetUserData());
+        if (bodyData) {
+            part.r = bodyData->r;
+            part.g = bodyData->g;
+            part.b = bodyData->b;
+        }
+
+        for (const b2Fixture *fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+            if (fixture->GetType() != b2Shape::e_polygon) {
+                continue;
+            }
+            auto *polygon = static_cast<const b2PolygonShape *>(fixture->GetShape());
+
+            FixtureDesign fixtureDesign;
+            fixtureDesign.density = fixture->GetDensity();
+            fixtureDesign.friction = fixture->GetFriction();
+            fixtureDesign.restitution = fixture->GetRestitution();
+            fixtureDesign.vertexCount = polygon->GetVertexCount();
+            for (int i = 0; i < fixtureDesign.vertexCount; ++i) {
+                fixtureDesign.vertices[i] = polygon->GetVertex(i);
+            }
+            part.fixtures.push_back(fixtureDesign);
+        }
+
+        design.parts.push_back(part);
+    }
+
+    return design;
+}
+
+uint64_t hashGenome(const Creature *creature) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hashFloat(hash, creature->getOffsetX());
+    hashFloat(hash, creature->getOffsetY());
+
+    for (const b2Body *body: creature->getBodyParts()) {
+        auto *bodyData = static_cast<const BodyData *>(body->GetUserData());
+        if (bodyData) {
+            hashFloat(hash, bodyData->r);
+            hashFloat(hash, bodyData->g);
+            hashFloat(hash, bodyData->b);
+        }
+
+        for (const b2Fixture *fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+            hashFloat(hash, fixture->GetDensity());
+            hashFloat(hash, fixture->GetFriction());
+            hashFloat(hash, fixture->GetRestitution());
+            if (fixture->GetType() == b2Shape::e_polygon) {
+                auto *polygon = static_cast<const b2PolygonShape *>(fixture->GetShape());
+                for (int i = 0; i < polygon->GetVertexCount(); ++i) {
+                    hashFloat(hash, polygon->GetVertex(i).x);
+                    hashFloat(hash, polygon->GetVertex(i).y);
+                }
+            }
+        }
+        // Part boundary, so moving a fixture from one part to the next changes the hash
+        hash = (hash ^ 0xffu) * FNV_PRIME;
+    }
+
+    return hash;
+}
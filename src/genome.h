@@ -0,0 +1,55 @@
+#ifndef LIQUIDFUN_EVO_SIM_GENOME_H
+#define LIQUIDFUN_EVO_SIM_GENOME_H
+
+#include <Box2D/Box2D.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "creature.h"
+
+// Plain description of a creature's body plan that can be saved, edited by hand and rebuilt in any world.
+//
+// Text format, one directive per line ('#' starts a comment):
+//   creature NAME OFFSET_X OFFSET_Y
+//   part X Y ANGLE R G B                                  body position relative to the creature's origin
+//   box WIDTH HEIGHT [DENSITY FRICTION RESTITUTION]        box fixture on the last part
+//   polygon DENSITY FRICTION RESTITUTION N X1 Y1 ... XN YN  polygon fixture on the last part
+//   end
+
+struct FixtureDesign {
+    float density = 1.0f;
+    float friction = 0.3f;
+    float restitution = 0.0f;
+    int vertexCount = 0;
+    b2Vec2 vertices[b2_maxPolygonVertices];
+};
+
+struct BodyPartDesign {
+    b2Vec2 position = b2Vec2(0.0f, 0.0f);
+    float angle = 0.0f;
+    float r = 0.0f, g = 1.0f, b = 0.0f;
+    std::vector<FixtureDesign> fixtures;
+};
+
+struct CreatureDesign {
+    std::string name;
+    float offsetX = 2.0f;
+    float offsetY = 2.0f;
+    std::vector<BodyPartDesign> parts;
+};
+
+bool readDesigns(const std::string &path, std::vector<CreatureDesign> &designs);
+
+bool writeDesigns(const std::string &path, const std::vector<CreatureDesign> &designs);
+
+// Creates the creature's bodies in `world` with part positions relative to `origin`.
+Creature *buildCreature(b2World *world, const CreatureDesign &design, const b2Vec2 &origin);
+
+// Design of an existing creature, with part positions relative to its first body part.
+CreatureDesign describeCreature(const Creature *creature, const std::string &name);
+
+// 64-bit FNV-1a over the heritable traits: offsets, part colors and every fixture's material and shape.
+// Body positions are left out since they change as the creature moves.
+uint64_t hashGenome(const Creature *creature);
+
+#endif //LIQUIDFUN_EVO_SIM_GENOME_H
@@ -0,0 +1,46 @@
+#include <iostream>
+#include "lineage.h"
+#include "run_options.h"
+#include "simulation.h"
+#include "thread_pool.h"
+
+// liquidfun_evo_sim without the window: Simulation<HeadlessConfig> with the same options and outputs (frame
+// capture, recording, publishing, stats, lineage and design export). Links only the core, so it builds and
+// runs on machines without OpenGL. Runs until --ticks, or until killed when that is 0.
+int main(int argc, char **argv) {
+    RunOptions options;
+    if (!parseRunOptions(argc, argv, options)) {
+        printRunUsage(argv[0]);
+        return 1;
+    }
+
+    if (!options.replayPath.empty()) {
+        std::cerr << "Replay playback needs a window; use liquidfun_evo_sim --replay" << std::endl;
+        return 1;
+    }
+
+    LineageStore lineage;
+    if (!options.lineagePath.empty() && !lineage.create(options.lineagePath)) {
+        return 1;
+    }
+
+    // Created here so --threads sizes it before frame capture first asks for it
+    ThreadPool &pool = sharedThreadPool(options.threads);
+
+    Simulation<HeadlessConfig> simulation(options.params, lineage.isOpen() ? &lineage : nullptr, &pool);
+
+    RunOutputs outputs(options);
+    if (!outputs.open()) {
+        return 1;
+    }
+
+    while (options.maxTicks == 0 || simulation.getTick() < options.maxTicks) {
+        unsigned long tick = simulation.getTick();
+        simulation.step();
+        outputs.afterTick(tick, simulation.getCreatures(), simulation.getParticleSystem(),
+                          simulation.getInstrumentation());
+    }
+
+    outputs.finish(simulation.getCreatures());
+    return 0;
+}
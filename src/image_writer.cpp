@@ -0,0 +1,297 @@
+#include "image_writer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    std::vector<uint32_t> buildCrcTable() {
+        std::vector<uint32_t> table(256);
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }
+
+    uint32_t updateCrc(uint32_t crc, const uint8_t *data, size_t length) {
+        static const std::vector<uint32_t> crcTable = buildCrcTable();
+        for (size_t i = 0; i < length; ++i) {
+            crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    void appendBigEndian(std::vector<uint8_t> &out, uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Returns false if any of it could not be written
+    bool writeChunk(FILE *file, const char *type, const std::vector<uint8_t> &data) {
+        std::vector<uint8_t> header;
+        appendBigEndian(header, static_cast<uint32_t>(data.size()));
+        header.insert(header.end(), type, type + 4);
+
+        uint32_t crc = updateCrc(0xFFFFFFFFu, header.data() + 4, 4);
+        crc = updateCrc(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+
+        std::vector<uint8_t> footer;
+        appendBigEndian(footer, crc);
+
+        bool ok = fwrite(header.data(), 1, header.size(), file) == header.size();
+        ok &= data.empty() || fwrite(data.data(), 1, data.size(), file) == data.size();
+        ok &= fwrite(footer.data(), 1, footer.size(), file) == footer.size();
+        return ok;
+    }
+
+    // Deflate emits bits least significant first; Huffman codes go in most significant bit first
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<uint8_t> &out) : out(out), buffer(0), bitCount(0) {}
+
+        void write(uint32_t bits, int length) {
+            buffer |= bits << bitCount;
+            bitCount += length;
+            while (bitCount >= 8) {
+                out.push_back(static_cast<uint8_t>(buffer));
+                buffer >>= 8;
+                bitCount -= 8;
+            }
+        }
+
+        void writeCode(uint32_t code, int length) {
+            uint32_t reversed = 0;
+            for (int i = 0; i < length; ++i) {
+                reversed = (reversed << 1) | ((code >> i) & 1);
+            }
+            write(reversed, length);
+        }
+
+        void flush() {
+            if (bitCount > 0) {
+                out.push_back(static_cast<uint8_t>(buffer));
+            }
+            buffer = 0;
+            bitCount = 0;
+        }
+
+    private:
+        std::vector<uint8_t> &out;
+        uint32_t buffer;
+        int bitCount;
+    };
+
+    const int lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83,
+                                99, 115, 131, 163, 195, 227, 258};
+    const int lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5,
+                                 0};
+    const int distanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+                                  1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    const int distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+                                   12, 12, 13, 13};
+
+    // Fixed Huffman code of a literal/length symbol (RFC 1951, 3.2.6)
+    void writeSymbol(BitWriter &bits, int symbol) {
+        if (symbol < 144) {
+            bits.writeCode(0x30 + symbol, 8);
+        } else if (symbol < 256) {
+            bits.writeCode(0x190 + symbol - 144, 9);
+        } else if (symbol < 280) {
+            bits.writeCode(symbol - 256, 7);
+        } else {
+            bits.writeCode(0xC0 + symbol - 280, 8);
+        }
+    }
+
+    void writeMatch(BitWriter &bits, int length, int distance) {
+        int code = 28;
+        while (lengthBase[code] > length) {
+            --code;
+        }
+        writeSymbol(bits, 257 + code);
+        bits.write(static_cast<uint32_t>(length - lengthBase[code]), lengthExtra[code]);
+
+        code = 29;
+        while (distanceBase[code] > distance) {
+            --code;
+        }
+        bits.writeCode(static_cast<uint32_t>(code), 5);
+        bits.write(static_cast<uint32_t>(distance - distanceBase[code]), distanceExtra[code]);
+    }
+
+    // A single fixed-Huffman deflate block with greedy LZ77 matching over hash chains. Frames are mostly
+    // flat background, so even this finds long runs; dynamic Huffman tables would gain little more.
+    void deflateFixed(const std::vector<uint8_t> &data, std::vector<uint8_t> &out) {
+        const int WINDOW_SIZE = 32768;
+        const int HASH_SIZE = 1 << 15;
+        const int MAX_CHAIN = 16;
+        const int MIN_MATCH = 3;
+        const int MAX_MATCH = 258;
+
+        std::vector<int> head(HASH_SIZE, -1);
+        std::vector<int> previous(WINDOW_SIZE, -1);
+        auto hashAt = [&data](size_t i) {
+            return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & (HASH_SIZE - 1);
+        };
+
+        BitWriter bits(out);
+        bits.write(1, 1); // final block
+        bits.write(1, 2); // fixed Huffman codes
+
+        const size_t size = data.size();
+        size_t i = 0;
+        while (i < size) {
+            int bestLength = 0;
+            int bestDistance = 0;
+            if (i + MIN_MATCH <= size) {
+                int hash = hashAt(i);
+                int candidate = head[hash];
+                size_t maxLength = std::min<size_t>(MAX_MATCH, size - i);
+                for (int chain = 0; chain < MAX_CHAIN && candidate >= 0 &&
+                                    i - candidate <= static_cast<size_t>(WINDOW_SIZE); ++chain) {
+                    size_t length = 0;
+                    while (length < maxLength && data[candidate + length] == data[i + length]) {
+                        ++length;
+                    }
+                    if (static_cast<int>(length) > bestLength) {
+                        bestLength = static_cast<int>(length);
+                        bestDistance = static_cast<int>(i - candidate);
+                        if (length == maxLength) {
+                            break;
+                        }
+                    }
+                    candidate = previous[candidate % WINDOW_SIZE];
+                }
+            }
+
+            size_t advance = 1;
+            if (bestLength >= MIN_MATCH) {
+                writeMatch(bits, bestLength, bestDistance);
+                advance = static_cast<size_t>(bestLength);
+            } else {
+                writeSymbol(bits, data[i]);
+            }
+
+            for (size_t end = i + advance; i < end; ++i) {
+                if (i + MIN_MATCH <= size) {
+                    int hash = hashAt(i);
+                    previous[i % WINDOW_SIZE] = head[hash];
+                    head[hash] = static_cast<int>(i);
+                }
+            }
+        }
+
+        writeSymbol(bits, 256);
+        bits.flush();
+    }
+
+    inline uint8_t paethPredictor(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) {
+            return static_cast<uint8_t>(a);
+        }
+        return static_cast<uint8_t>(pb <= pc ? b : c);
+    }
+
+    // Appends one scanline with whichever of None/Sub/Up/Paeth gives the smallest sum of absolute
+    // (signed) residuals, the usual heuristic from the PNG spec.
+    void appendFilteredRow(std::vector<uint8_t> &out, const uint8_t *row, const uint8_t *above, size_t rowSize) {
+        const int BYTES_PER_PIXEL = 3;
+        std::vector<uint8_t> candidates[4];
+        int bestFilter = 0;
+        long bestScore = -1;
+        for (int filter = 0; filter < 4; ++filter) {
+            std::vector<uint8_t> &filtered = candidates[filter];
+            filtered.resize(rowSize);
+            long score = 0;
+            for (size_t x = 0; x < rowSize; ++x) {
+                int left = x >= BYTES_PER_PIXEL ? row[x - BYTES_PER_PIXEL] : 0;
+                int up = above ? above[x] : 0;
+                int upLeft = above && x >= BYTES_PER_PIXEL ? above[x - BYTES_PER_PIXEL] : 0;
+                int predicted = filter == 0 ? 0 : filter == 1 ? left : filter == 2 ? up
+                                                                               : paethPredictor(left, up, upLeft);
+                filtered[x] = static_cast<uint8_t>(row[x] - predicted);
+                score += std::abs(static_cast<int8_t>(filtered[x]));
+            }
+            if (bestScore < 0 || score < bestScore) {
+                bestScore = score;
+                bestFilter = filter;
+            }
+        }
+
+        // PNG filter types: 0 None, 1 Sub, 2 Up, 4 Paeth
+        out.push_back(static_cast<uint8_t>(bestFilter == 3 ? 4 : bestFilter));
+        out.insert(out.end(), candidates[bestFilter].begin(), candidates[bestFilter].end());
+    }
+}
+
+bool writePPM(const std::string &path, const uint8_t *rgb, int width, int height) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    size_t size = static_cast<size_t>(width) * height * 3;
+    bool ok = fwrite(rgb, 1, size, file) == size;
+
+    return fclose(file) == 0 && ok;
+}
+
+bool writePNG(const std::string &path, const uint8_t *rgb, int width, int height) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    bool ok = fwrite(signature, 1, sizeof(signature), file) == sizeof(signature);
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, static_cast<uint32_t>(width));
+    appendBigEndian(header, static_cast<uint32_t>(height));
+    header.push_back(8); // bit depth
+    header.push_back(2); // color type: RGB
+    header.push_back(0); // compression
+    header.push_back(0); // filter
+    header.push_back(0); // interlace
+    ok &= writeChunk(file, "IHDR", header);
+
+    // Filtered scanlines, each prefixed with its filter type
+    size_t rowSize = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        appendFilteredRow(raw, rgb + y * rowSize, y > 0 ? rgb + (y - 1) * rowSize : nullptr, rowSize);
+    }
+
+    std::vector<uint8_t> zlib;
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    deflateFixed(raw, zlib);
+
+    // Adler-32 of the uncompressed data. 5552 bytes is the most that can be summed before b overflows.
+    uint32_t a = 1, b = 0;
+    for (size_t blockStart = 0; blockStart < raw.size(); blockStart += 5552) {
+        size_t blockEnd = std::min(raw.size(), blockStart + 5552);
+        for (size_t i = blockStart; i < blockEnd; ++i) {
+            a += raw[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    appendBigEndian(zlib, (b << 16) | a);
+
+    ok &= writeChunk(file, "IDAT", zlib);
+    ok &= writeChunk(file, "IEND", std::vector<uint8_t>());
+
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,15 @@
+#ifndef LIQUIDFUN_EVO_SIM_IMAGE_WRITER_H
+#define LIQUIDFUN_EVO_SIM_IMAGE_WRITER_H
+
+#include <cstdint>
+#include <string>
+
+// Both writers take tightly packed 8-bit RGB pixels, top row first, and return false if the file could
+// not be written.
+
+bool writePPM(const std::string &path, const uint8_t *rgb, int width, int height);
+
+// Writes a filtered, fixed-Huffman deflate compressed PNG, so no zlib dependency is needed.
+bool writePNG(const std::string &path, const uint8_t *rgb, int width, int height);
+
+#endif //LIQUIDFUN_EVO_SIM_IMAGE_WRITER_H
@@ -0,0 +1,205 @@
+#include "lineage.h"
+#include "genome.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+    const char LINEAGE_MAGIC[8] = {'E', 'V', 'O', 'L', 'I', 'N', 'E', '1'};
+    const uint32_t LINEAGE_VERSION = 1;
+
+    // Grow by doubling, but never by more than this many records at once (512 MiB)
+    const uint64_t INITIAL_RECORDS = 1 << 16;
+    const uint64_t MAX_GROWTH_RECORDS = 1 << 24;
+
+    size_t bytesFor(uint64_t records) {
+        return sizeof(LineageHeader) + static_cast<size_t>(records) * sizeof(LineageRecord);
+    }
+}
+
+LineageStore::~LineageStore() {
+    close();
+}
+
+bool LineageStore::create(const std::string &path) {
+    close();
+    if (!file.createFile(path, bytesFor(INITIAL_RECORDS))) {
+        return false;
+    }
+
+    header = static_cast<LineageHeader *>(file.getData());
+    records = reinterpret_cast<LineageRecord *>(header + 1);
+    memcpy(header->magic, LINEAGE_MAGIC, sizeof(LINEAGE_MAGIC));
+    header->version = LINEAGE_VERSION;
+    header->recordSize = sizeof(LineageRecord);
+    header->recordCount = 0;
+    file.setUsedSize(bytesFor(0));
+    return true;
+}
+
+bool LineageStore::open(const std::string &path) {
+    close();
+    if (!file.openFile(path)) {
+        return false;
+    }
+
+    auto *candidate = static_cast<LineageHeader *>(file.getData());
+    if (file.getSize() < sizeof(LineageHeader) || memcmp(candidate->magic, LINEAGE_MAGIC, sizeof(LINEAGE_MAGIC)) != 0 ||
+        candidate->version != LINEAGE_VERSION || candidate->recordSize != sizeof(LineageRecord) ||
+        file.getSize() < bytesFor(candidate->recordCount)) {
+        std::cerr << path << " is not a compatible lineage store" << std::endl;
+        file.close();
+        return false;
+    }
+
+    header = candidate;
+    records = reinterpret_cast<LineageRecord *>(header + 1);
+    return true;
+}
+
+void LineageStore::close() {
+    file.flush();
+    file.close();
+    header = nullptr;
+    records = nullptr;
+}
+
+bool LineageStore::reserve(uint64_t count) {
+    if (bytesFor(count) <= file.getSize()) {
+        return true;
+    }
+
+    uint64_t capacity = (file.getSize() - sizeof(LineageHeader)) / sizeof(LineageRecord);
+    uint64_t growth = std::min(std::max(capacity, INITIAL_RECORDS), MAX_GROWTH_RECORDS);
+    if (!file.grow(bytesFor(std::max(count, capacity + growth)))) {
+        header = nullptr;
+        records = nullptr;
+        return false;
+    }
+
+    header = static_cast<LineageHeader *>(file.getData());
+    records = reinterpret_cast<LineageRecord *>(header + 1);
+    return true;
+}
+
+void LineageStore::recordBirth(const Creature *creature, uint64_t tick) {
+    if (!header || !file.isWritable()) {
+        return;
+    }
+
+    uint64_t count = header->recordCount;
+    if (count > 0 && creature->getId() <= records[count - 1].id) {
+        std::cerr << "Lineage: creature " << creature->getId() << " born out of id order, not recorded" << std::endl;
+        return;
+    }
+    if (!reserve(count + 1)) {
+        std::cerr << "Lineage: store is full, recording stopped" << std::endl;
+        return;
+    }
+
+    LineageRecord &record = records[count];
+    record.id = creature->getId();
+    record.parentId = creature->getParentId();
+    record.birthTick = tick;
+    record.deathTick = LINEAGE_ALIVE;
+    record.genomeHash = hashGenome(creature);
+
+    // Publish the record only once it is complete
+    header->recordCount = count + 1;
+    file.setUsedSize(bytesFor(count + 1));
+}
+
+void LineageStore::recordDeath(uint32_t id, uint64_t tick) {
+    if (!header || !file.isWritable()) {
+        return;
+    }
+    auto *record = const_cast<LineageRecord *>(find(id));
+    if (record) {
+        record->deathTick = tick;
+    }
+}
+
+void LineageStore::flush() {
+    file.flush();
+}
+
+const LineageRecord *LineageStore::find(uint32_t id) const {
+    if (!header) {
+        return nullptr;
+    }
+    const LineageRecord *begin = records;
+    const LineageRecord *end = begin + header->recordCount;
+    const LineageRecord *found = std::lower_bound(begin, end, id, [](const LineageRecord &record, uint32_t key) {
+        return record.id < key;
+    });
+    return found != end && found->id == id ? found : nullptr;
+}
+
+void LineageStore::ancestors(uint32_t id, std::vector<uint32_t> &ancestry) const {
+    ancestry.clear();
+    const LineageRecord *record = find(id);
+    while (record && record->parentId != 0) {
+        ancestry.push_back(record->parentId);
+        record = find(record->parentId);
+    }
+}
+
+uint32_t LineageStore::mostRecentCommonAncestor(uint32_t a, uint32_t b) const {
+    // Parents are always older than their children, so stepping the younger side up keeps both walks in
+    // step without storing either ancestry
+    while (a != 0 && b != 0 && a != b) {
+        uint32_t &younger = a > b ? a : b;
+        const LineageRecord *record = find(younger);
+        younger = record ? record->parentId : 0;
+    }
+    return a == b ? a : 0;
+}
+
+void LineageStore::collectLiving(std::vector<uint32_t> &living) const {
+    living.clear();
+    for (uint64_t i = 0; i < size(); ++i) {
+        if (records[i].deathTick == LINEAGE_ALIVE) {
+            living.push_back(records[i].id);
+        }
+    }
+}
+
+size_t LineageStore::survivingLineages(const std::vector<uint32_t> &living, uint64_t tick,
+                                       std::map<uint32_t, size_t> *members) const {
+    // Lineage root of every creature visited so far; siblings share most of their ancestry
+    std::unordered_map<uint32_t, uint32_t> roots;
+    std::map<uint32_t, size_t> counts;
+    std::vector<uint32_t> path;
+
+    for (uint32_t id: living) {
+        path.clear();
+        uint32_t root = 0;
+        uint32_t current = id;
+        while (current != 0) {
+            auto known = roots.find(current);
+            if (known != roots.end()) {
+                root = known->second;
+                break;
+            }
+            path.push_back(current);
+
+            const LineageRecord *record = find(current);
+            if (!record || record->birthTick <= tick || record->parentId == 0) {
+                root = current;
+                break;
+            }
+            current = record->parentId;
+        }
+
+        for (uint32_t visited: path) {
+            roots[visited] = root;
+        }
+        ++counts[root];
+    }
+
+    if (members) {
+        *members = counts;
+    }
+    return counts.size();
+}
@@ -0,0 +1,98 @@
+#ifndef LIQUIDFUN_EVO_SIM_LINEAGE_H
+#define LIQUIDFUN_EVO_SIM_LINEAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "creature.h"
+#include "memory_mapping.h"
+
+// Append-only record of every creature ever born, kept in a memory-mapped file so runs with hundreds of
+// millions of births never hold the history in RAM; the OS pages it in and out as queries touch it.
+//
+// Layout: LineageHeader, then recordCount LineageRecords in birth order. Creature ids only ever increase,
+// so records are also sorted by id and lookups are a binary search.
+
+#define LINEAGE_ALIVE UINT64_MAX
+
+struct LineageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t recordCount;
+    uint64_t reserved[5];
+};
+
+struct LineageRecord {
+    uint32_t id;
+    uint32_t parentId; // 0 for the founders
+    uint64_t birthTick;
+    uint64_t deathTick; // LINEAGE_ALIVE until the creature dies (or the run ends)
+    uint64_t genomeHash;
+};
+
+static_assert(sizeof(LineageHeader) == 64, "lineage header layout is part of the file format");
+static_assert(sizeof(LineageRecord) == 32, "lineage record layout is part of the file format");
+
+class LineageStore {
+public:
+    LineageStore() : header(nullptr), records(nullptr) {}
+
+    // Flushes and trims the file.
+    ~LineageStore();
+
+    LineageStore(const LineageStore &) = delete;
+
+    LineageStore &operator=(const LineageStore &) = delete;
+
+    bool create(const std::string &path);
+
+    // Opens an existing store for queries only.
+    bool open(const std::string &path);
+
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+
+    uint64_t size() const { return header ? header->recordCount : 0; }
+
+    // Births must be recorded in id order, which is the order creatures are constructed in.
+    void recordBirth(const Creature *creature, uint64_t tick);
+
+    void recordDeath(uint32_t id, uint64_t tick);
+
+    // Asks the OS to write dirty pages back now rather than whenever it gets round to it.
+    void flush();
+
+    const LineageRecord &at(uint64_t index) const { return records[index]; }
+
+    // nullptr if the id was never recorded
+    const LineageRecord *find(uint32_t id) const;
+
+    // Parent first, founder last.
+    void ancestors(uint32_t id, std::vector<uint32_t> &ancestry) const;
+
+    // Youngest creature both descend from (a creature counts as its own ancestor), or 0 if they come from
+    // different founders.
+    uint32_t mostRecentCommonAncestor(uint32_t a, uint32_t b) const;
+
+    // Ids of every creature with no recorded death. Scans the whole store.
+    void collectLiving(std::vector<uint32_t> &living) const;
+
+    // Number of lineages that still have living members, where a lineage is everything descended from one
+    // creature that was alive at `tick` (the founders for tick 0). `members`, if given, receives the number
+    // of living creatures per lineage root.
+    size_t survivingLineages(const std::vector<uint32_t> &living, uint64_t tick,
+                             std::map<uint32_t, size_t> *members = nullptr) const;
+
+private:
+    bool reserve(uint64_t count);
+
+    MemoryMapping file;
+    LineageHeader *header;
+    LineageRecord *records;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_LINEAGE_H
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "lineage.h"
+
+namespace {
+    void printRecord(const LineageStore &store, uint32_t id) {
+        const LineageRecord *record = store.find(id);
+        if (!record) {
+            std::cout << id << " (not recorded)" << std::endl;
+            return;
+        }
+        std::cout << record->id << " born " << record->birthTick;
+        if (record->deathTick == LINEAGE_ALIVE) {
+            std::cout << ", alive";
+        } else {
+            std::cout << ", died " << record->deathTick;
+        }
+        std::cout << ", genome " << std::hex << record->genomeHash << std::dec << std::endl;
+    }
+}
+
+// Queries a lineage store written with --lineage.
+int main(int argc, char **argv) {
+    const char *command = argc > 2 ? argv[2] : "summary";
+    bool valid = argc > 1 && ((strcmp(command, "summary") == 0 && argc <= 3) ||
+                              (strcmp(command, "ancestors") == 0 && argc == 4) ||
+                              (strcmp(command, "mrca") == 0 && argc == 5) ||
+                              (strcmp(command, "survivors") == 0 && argc <= 4));
+    if (!valid) {
+        std::cerr << "Usage: " << argv[0] << " FILE [summary | ancestors ID | mrca ID ID | survivors [TICK]]"
+                  << std::endl;
+        return 1;
+    }
+
+    LineageStore store;
+    if (!store.open(argv[1])) {
+        return 1;
+    }
+
+    if (strcmp(command, "summary") == 0) {
+        std::vector<uint32_t> living;
+        store.collectLiving(living);
+        uint64_t founders = 0;
+        uint64_t lastTick = 0;
+        for (uint64_t i = 0; i < store.size(); ++i) {
+            const LineageRecord &record = store.at(i);
+            founders += record.parentId == 0 ? 1 : 0;
+            lastTick = std::max(lastTick, record.birthTick);
+            if (record.deathTick != LINEAGE_ALIVE) {
+                lastTick = std::max(lastTick, record.deathTick);
+            }
+        }
+        std::cout << store.size() << " births, " << founders << " founders, " << living.size()
+                  << " alive at the end, last event at tick " << lastTick << ", "
+                  << store.survivingLineages(living, 0) << " founder lineages surviving" << std::endl;
+    } else if (strcmp(command, "ancestors") == 0) {
+        auto id = static_cast<uint32_t>(strtoul(argv[3], nullptr, 10));
+        std::vector<uint32_t> ancestry;
+        store.ancestors(id, ancestry);
+        printRecord(store, id);
+        for (uint32_t ancestor: ancestry) {
+            printRecord(store, ancestor);
+        }
+    } else if (strcmp(command, "mrca") == 0) {
+        auto a = static_cast<uint32_t>(strtoul(argv[3], nullptr, 10));
+        auto b = static_cast<uint32_t>(strtoul(argv[4], nullptr, 10));
+        uint32_t ancestor = store.mostRecentCommonAncestor(a, b);
+        if (ancestor == 0) {
+            std::cout << "No common ancestor" << std::endl;
+        } else {
+            printRecord(store, ancestor);
+        }
+    } else {
+        uint64_t tick = argc > 3 ? strtoull(argv[3], nullptr, 10) : 0;
+        std::vector<uint32_t> living;
+        store.collectLiving(living);
+        std::map<uint32_t, size_t> members;
+        size_t lineages = store.survivingLineages(living, tick, &members);
+        std::cout << lineages << " lineages from tick " << tick << " still alive" << std::endl;
+        for (const auto &lineage: members) {
+            std::cout << "  " << lineage.first << ": " << lineage.second << " living" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -4,219 +4,144 @@
 #include <vector>
 #include "creature.h"
 #include "rendering.h"
-#include <random>
-#include <chrono>
-
-
-static const float WORLD_SIZE = 100.0f;
-
-b2Body *createWorldBoundaries(b2World &world, float squareWidth);
-
-void clampCreaturePositions(std::list<Creature *> creatureList, float minX, float maxX, float minY, float maxY) {
-    for (Creature *creature: creatureList) {
-        for (b2Body *bodyPart: creature->getBodyParts()) {
-            b2Vec2 position = bodyPart->GetPosition();
-
-            float clampedX = std::max(minX, std::min(position.x, maxX));
-            float clampedY = std::max(minY, std::min(position.y, maxY));
-
-            if (position.x != clampedX || position.y != clampedY) {
-                bodyPart->SetTransform(b2Vec2(clampedX, clampedY), bodyPart->GetAngle());
-            }
-        }
+#include "lineage.h"
+#include "population_index.h"
+#include "replay.h"
+#include "run_options.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+
+// The windowed simulation: GL drawing plus full bookkeeping
+struct InteractiveConfig {
+    typedef GLRenderer Renderer;
+    typedef ParticleFood Food;
+    typedef RandomForceLocomotion Locomotion;
+    typedef std::mt19937 Rng;
+    typedef FullInstrumentation Instrumentation;
+};
+
+// Plays a replay file through the renderer only. Space pauses, up/down double or halve the speed and
+// left/right jump back or forward by ten keyframes.
+int runReplay(const RunOptions &options) {
+    ReplayPlayer player(options.replayPath);
+    if (!player.isOpen()) {
+        return 1;
     }
-}
-
-
-int main(int argc, char **argv) {
-
-
-    // Create a world with gravity
-    b2Vec2 gravity(0.0f, -1.0f);
-    b2World world(gravity);
-
-    createWorldBoundaries(world, WORLD_SIZE);
-
-//    WaterContactListener myContactListener;
-//    world.SetContactListener(&myContactListener);
-
-    // Create a dynamic body
-    auto *creature1 = new Creature();
-    creature1->addBodyPart(Creature::createBodyPart(&world, creature1, 5.0f, 5.0f, 1.0f, 1.0f));
-
-
-    auto *creature2 = new Creature();
-    creature1->addBodyPart(Creature::createBodyPart(&world, creature2, 15.0f, 5.0f, 2.0f, 2.0f));
-
-    std::list<Creature *> creatureList;
-    creatureList.push_back(creature1);
-    creatureList.push_back(creature2);
-
-    // Create a particle system
-    b2ParticleSystemDef particleSystemDef;
-    particleSystemDef.radius = 0.1f;
-//    particleSystemDef.gravityScale = 0.01f;
-//    particleSystemDef.powderStrength = 3.0f;
-    particleSystemDef.surfaceTensionNormalStrength = 1.0f;
-    particleSystemDef.surfaceTensionPressureStrength = 1.0f;
-    particleSystemDef.staticPressureStrength = 5.0f;
-    b2ParticleSystem *particleSystem = world.CreateParticleSystem(&particleSystemDef);
-
-    // Create a particle group
-    b2PolygonShape airParticlesShape;
-    airParticlesShape.SetAsBox(4, 4);
-
-    b2ParticleGroupDef particleGroupDef;
-    particleGroupDef.shape = &airParticlesShape;
-    particleGroupDef.flags = b2_waterParticle;
-//    particleGroupDef.flags = b2_powderParticle;
-    particleGroupDef.position.Set(10.0f, 4.0f);
-    particleSystem->CreateParticleGroup(particleGroupDef);
-
-    float32 timeStep = 1.0f / 60.0f;
-    int32 velocityIterations = 6;
-    int32 positionIterations = 2;
-    int32 particleIterations = 1;
 
-    // Initialize GLFW and create a window
     GLFWwindow *window = initGLFW();
+    if (!window) {
+        return 1;
+    }
 
-    // Run the physics simulation and render the scene
-    while (!glfwWindowShouldClose(window)) {
-
-        float minX = 0.5f;
-        float maxX = WORLD_SIZE - 0.5f;
-        float minY = 0.5f;
-        float maxY = WORLD_SIZE - 0.5f;
-
-        clampCreaturePositions(creatureList, minX, maxX, minY, maxY);
-
-        // Define the minimum number of particles
-        const int32 minParticleCount = 600;
-
-        // Check the number of particles in the particleSystem during the main loop
-        int32 currentParticleCount = particleSystem->GetParticleCount();
-
-        // Ensure the particleSystem has at least the minimum number of particles
-        if (currentParticleCount < minParticleCount) {
-            int32 particlesToCreate = minParticleCount - currentParticleCount;
-
-            // Create new particles to reach the minimum count
-            // You'll need to define the particle properties using a b2ParticleDef
-            b2ParticleDef particleDef;
-            particleDef.flags = particleGroupDef.flags;
-            particleDef.position = b2Vec2(WORLD_SIZE * ((float) rand() / RAND_MAX),
-                                          WORLD_SIZE * ((float) rand() / RAND_MAX));
-            particleDef.color = particleGroupDef.color;
-            particleDef.lifetime = particleGroupDef.lifetime;
-            particleDef.userData = particleGroupDef.userData;
+    float speed = std::max(options.replaySpeed, 0.0f);
+    float pendingTicks = 0.0f;
+    bool paused = false;
+    unsigned long jump = 10 * std::max(1ul, player.getKeyframeInterval());
+    WorldSnapshot snapshot;
+    char title[128];
 
-            // Create the particles
-            for (int32 i = 0; i < particlesToCreate; ++i) {
-                particleSystem->CreateParticle(particleDef);
-            }
+    while (!glfwWindowShouldClose(window)) {
+        if (consumeKeyPress(GLFW_KEY_SPACE)) {
+            paused = !paused;
+        }
+        if (consumeKeyPress(GLFW_KEY_UP)) {
+            speed = std::max(speed * 2.0f, 1.0f);
+        }
+        if (consumeKeyPress(GLFW_KEY_DOWN)) {
+            speed *= 0.5f;
+        }
+        if (consumeKeyPress(GLFW_KEY_RIGHT)) {
+            player.seek(player.getTick() + jump);
+        }
+        if (consumeKeyPress(GLFW_KEY_LEFT)) {
+            player.seek(player.getTick() > player.getFirstTick() + jump ? player.getTick() - jump
+                                                                         : player.getFirstTick());
         }
 
-
-        // Get the number of body contacts
-        int32 bodyContactCount = particleSystem->GetBodyContactCount();
-
-        // Get the array of body contacts
-        const b2ParticleBodyContact *bodyContacts = particleSystem->GetBodyContacts();
-
-        // Iterate over the body contacts
-        for (int32 i = 0; i < bodyContactCount; ++i) {
-            // Access the i-th body contact
-            const b2ParticleBodyContact &contact = bodyContacts[i];
-
-            // Get the indices of the particle and body involved in the contact
-            int32 particleIndex = contact.index;
-            b2Body *contactedBody = contact.body;
-
-            if (contactedBody->GetType() == b2_dynamicBody) {
-                // Perform any desired operations using the contact information
-                auto *bodyData = static_cast<BodyData *>(contactedBody->GetUserData());
-                Creature *parentCreature = bodyData->parentCreature;
-                parentCreature->addToHealth(0.01f);
-
-//                particleSystem->DestroyParticle(particleIndex);
+        if (!paused) {
+            pendingTicks += speed;
+            auto ticks = static_cast<unsigned long>(pendingTicks);
+            pendingTicks -= static_cast<float>(ticks);
+            if (ticks > 0) {
+                player.advance(ticks);
             }
         }
 
+        player.toSnapshot(snapshot);
+        drawSnapshot(snapshot);
 
-        // Step the world
-        world.Step(timeStep, velocityIterations, positionIterations, particleIterations);
-
-        std::list<Creature *> newCreatureList;
-
-        // Process creature growth
-        for (Creature *creatureToCheck: creatureList) {
+        snprintf(title, sizeof(title), "Replay tick %lu / %lu  speed %gx%s", player.getTick(),
+                 player.getLastTick(), speed, paused ? "  (paused)" : "");
+        glfwSetWindowTitle(window, title);
 
-            for (b2Body* movingBody : creatureToCheck->getBodyParts()) {
-
-                // Define the random number generator with a seed based on current time
-                std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count());
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
 
-                // Define the uniform distribution for angles between 0 and 2π
-                std::uniform_real_distribution<float> angle_distribution(0.0f, 2.0f * b2_pi);
+    cleanUpScene();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
 
-                // Generate a random angle
-                float impulse_orientation = angle_distribution(rng);
-                // Apply the impulse to the body at the specified location and orientation
-                float impulse_magnitude = 1;  // The magnitude of the impulse
-                b2Vec2 impulse_vector = b2Vec2(impulse_magnitude * cos(impulse_orientation),
-                                               impulse_magnitude * sin(impulse_orientation));
-                movingBody->ApplyForceToCenter(impulse_vector, true);
+int main(int argc, char **argv) {
 
-            }
+    RunOptions options;
+    if (!parseRunOptions(argc, argv, options)) {
+        printRunUsage(argv[0]);
+        return 1;
+    }
 
-            creatureToCheck->addToHealth(-0.02f);
+    if (!options.replayPath.empty()) {
+        return runReplay(options);
+    }
 
-            // Reproduce successful creatures
-            if (creatureToCheck->getHealth() > 200.0f) {
+    LineageStore lineage;
+    if (!options.lineagePath.empty() && !lineage.create(options.lineagePath)) {
+        return 1;
+    }
 
-                creatureToCheck->addToHealth(-100.0f);
+    // Created here so --threads sizes it before rendering or frame capture first ask for it
+    ThreadPool &pool = sharedThreadPool(options.threads);
 
-                Creature *newCreature = creatureToCheck->reproduce(&world);
+    Simulation<InteractiveConfig> simulation(options.params, lineage.isOpen() ? &lineage : nullptr,
+                                             &pool);
 
+    // Initialize GLFW and create a window
+    GLFWwindow *window = initGLFW();
+    if (!window) {
+        return 1;
+    }
 
-                // Add the new creature to the creatureList
-                newCreatureList.push_back(newCreature);
-            }
+    RunOutputs outputs(options);
+    if (!outputs.open()) {
+        return 1;
+    }
 
-        }
+    const std::list<Creature *> &creatureList = simulation.getCreatures();
+    char title[128];
 
-        creatureList.splice(creatureList.end(), newCreatureList);
+    // Run the physics simulation and render the scene
+    while (!glfwWindowShouldClose(window) && (options.maxTicks == 0 || simulation.getTick() < options.maxTicks)) {
+        unsigned long tick = simulation.getTick();
+        simulation.step();
 
         // Draw the scene
-        drawScene(creatureList, particleSystem, WORLD_SIZE);
-
-        for (auto it = creatureList.begin(); it != creatureList.end(); /* no increment here */) {
-            Creature *creatureToCheck = *it;
-            // Remove dead creatures
-            // Check if the creature is dead
-            if (creatureToCheck->getHealth() < 1.0f) {
-                for (b2Body *bodyPart: creatureToCheck->getBodyParts()) {
-                    // Remove all fixtures attached to the body
-                    b2Fixture *fixture = bodyPart->GetFixtureList();
-                    while (fixture != NULL) {
-                        b2Fixture *next = fixture->GetNext();
-                        bodyPart->DestroyFixture(fixture);
-                        fixture = next;
-                    }
-                    // Delete the body from the world
-                    world.DestroyBody(bodyPart);
-                }
-
-                // Delete the creature
-                delete creatureToCheck;
-
-                // Erase the dead creature from the list and update the iterator
-                it = creatureList.erase(it);
-            } else {
-                // Move to the next creature if it's not dead
-                ++it;
-            }
+        simulation.render();
+        outputs.afterTick(tick, creatureList, simulation.getParticleSystem(), simulation.getInstrumentation());
+
+        // Twice a second is plenty for a title bar HUD
+        if (tick % 30 == 0) {
+            const PopulationIndex &population = simulation.getInstrumentation().getPopulationIndex();
+            const Creature *healthiest = population.healthiest();
+            snprintf(title, sizeof(title), "Population %zu  mean health %.1f  healthiest %.1f  3+ parts %zu",
+                     population.size(), population.getMeanHealth(), healthiest ? healthiest->getHealth() : 0.0f,
+                     population.countWithBodyPartsAtLeast(3));
+            glfwSetWindowTitle(window, title);
         }
 
         // Swap buffers and poll events
@@ -224,70 +149,12 @@ int main(int argc, char **argv) {
         glfwPollEvents();
     }
 
-
-    // Destroy world before closing application.
-    for (Creature *deleteCreature: creatureList) {
-        for (b2Body *deleteBody: deleteCreature->getBodyParts()) {
-
-            auto bodyData = static_cast<BodyData *>(deleteBody->GetUserData());
-            delete bodyData;
-
-            b2Fixture *fixture = deleteBody->GetFixtureList();
-            while (fixture != NULL) {
-                b2Fixture *next = fixture->GetNext();
-                deleteBody->DestroyFixture(fixture);
-                fixture = next;
-            }
-
-            world.DestroyBody(deleteBody);
-        }
-    }
-
-    creatureList.clear();
+    outputs.finish(creatureList);
 
     cleanUpScene();
     // Clean up GLFW
     glfwDestroyWindow(window);
     glfwTerminate();
 
-
     return 0;
 }
-
-
-b2Body *createWorldBoundaries(b2World &world, float squareWidth) {
-
-    b2BodyDef squareBodyDef;
-    squareBodyDef.type = b2_staticBody;
-    squareBodyDef.position.Set(0, 0); // You can adjust the position if needed
-    b2Body *squareBody = world.CreateBody(&squareBodyDef);
-
-    b2EdgeShape topEdge, bottomEdge, leftEdge, rightEdge;
-
-    // Set the vertices of the edge shapes
-    topEdge.Set(b2Vec2(0, squareWidth), b2Vec2(squareWidth, squareWidth));
-    bottomEdge.Set(b2Vec2(0, 0), b2Vec2(squareWidth, 0));
-    leftEdge.Set(b2Vec2(0, 0), b2Vec2(0, squareWidth));
-    rightEdge.Set(b2Vec2(squareWidth, 0), b2Vec2(squareWidth, squareWidth));
-
-    b2FixtureDef squareFixtureDef;
-    squareFixtureDef.density = 0; // Static bodies don't need density
-    squareFixtureDef.restitution = 0.5f; // Adjust the restitution (bounciness) if needed
-    squareFixtureDef.friction = 0.5f; // Adjust the friction if needed
-
-    // Attach the edge shapes to the square body
-    squareFixtureDef.shape = &topEdge;
-    squareBody->CreateFixture(&squareFixtureDef);
-
-    squareFixtureDef.shape = &bottomEdge;
-    squareBody->CreateFixture(&squareFixtureDef);
-
-    squareFixtureDef.shape = &leftEdge;
-    squareBody->CreateFixture(&squareFixtureDef);
-
-    squareFixtureDef.shape = &rightEdge;
-    squareBody->CreateFixture(&squareFixtureDef);
-
-    return squareBody;
-}
-
@@ -0,0 +1,106 @@
+#include "memory_accounting.h"
+#include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Dynamics/Contacts/b2PolygonContact.h>
+#include <algorithm>
+#include <list>
+#include <ostream>
+
+namespace {
+    // b2BlockAllocator size classes; larger requests go straight to b2Alloc
+    const size_t blockSizes[] = {16, 32, 64, 96, 128, 160, 192, 224, 256, 320, 384, 448, 512, 640};
+
+    size_t blockBytes(size_t size) {
+        for (size_t blockSize: blockSizes) {
+            if (size <= blockSize) {
+                return blockSize;
+            }
+        }
+        return size;
+    }
+
+    // One node of a std::list<T *>: the value plus next/prev pointers
+    const size_t LIST_NODE_BYTES = 3 * sizeof(void *);
+
+    // Per-particle buffers LiquidFun keeps for our particle flags: flags, position, velocity, group,
+    // accumulation, weight, static pressure, proxy (index + tag) and the lazily created color/user data.
+    const size_t PARTICLE_BYTES = sizeof(uint32) + 2 * sizeof(b2Vec2) + sizeof(void *) + 3 * sizeof(float32) +
+                                  2 * sizeof(int32) + sizeof(b2ParticleColor) + sizeof(void *);
+
+    void addFootprint(MemoryCounters &counters, const CreatureFootprint &footprint) {
+        counters.creatures += 1;
+        counters.bodies += footprint.bodies;
+        counters.fixtures += footprint.fixtures;
+        counters.creatureBytes += footprint.creatureBytes;
+        counters.userDataBytes += footprint.userDataBytes;
+        counters.bodyBytes += footprint.bodyBytes;
+        counters.fixtureBytes += footprint.fixtureBytes;
+    }
+
+    void subtractFootprint(MemoryCounters &counters, const CreatureFootprint &footprint) {
+        counters.creatures -= std::min<size_t>(counters.creatures, 1);
+        counters.bodies -= std::min(counters.bodies, footprint.bodies);
+        counters.fixtures -= std::min(counters.fixtures, footprint.fixtures);
+        counters.creatureBytes -= std::min(counters.creatureBytes, footprint.creatureBytes);
+        counters.userDataBytes -= std::min(counters.userDataBytes, footprint.userDataBytes);
+        counters.bodyBytes -= std::min(counters.bodyBytes, footprint.bodyBytes);
+        counters.fixtureBytes -= std::min(counters.fixtureBytes, footprint.fixtureBytes);
+    }
+}
+
+CreatureFootprint measureCreature(const Creature *creature) {
+    CreatureFootprint footprint;
+    footprint.creatureBytes = sizeof(Creature) + LIST_NODE_BYTES; // plus its node in creatureList
+
+    for (const b2Body *body: creature->getBodyParts()) {
+        footprint.bodies += 1;
+        footprint.creatureBytes += LIST_NODE_BYTES;
+        footprint.bodyBytes += blockBytes(sizeof(b2Body));
+        if (body->GetUserData()) {
+            footprint.userDataBytes += sizeof(BodyData);
+        }
+
+        for (const b2Fixture *fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+            footprint.fixtures += 1;
+            size_t shapeSize = fixture->GetType() == b2Shape::e_polygon ? sizeof(b2PolygonShape)
+                                                                        : sizeof(b2EdgeShape);
+            footprint.fixtureBytes += blockBytes(sizeof(b2Fixture)) + blockBytes(shapeSize) +
+                                      blockBytes(sizeof(b2FixtureProxy)) + sizeof(b2TreeNode);
+        }
+    }
+
+    return footprint;
+}
+
+void MemoryAccounting::onCreatureBorn(const Creature *creature) {
+    addFootprint(counters, measureCreature(creature));
+    counters.peakBytes = std::max(counters.peakBytes, counters.totalBytes());
+}
+
+void MemoryAccounting::onCreatureDied(const Creature *creature) {
+    subtractFootprint(counters, measureCreature(creature));
+}
+
+void MemoryAccounting::update(const b2World &world, const b2ParticleSystem &particleSystem) {
+    counters.contacts = static_cast<size_t>(world.GetContactCount());
+    counters.contactBytes = counters.contacts * blockBytes(sizeof(b2PolygonContact));
+
+    counters.particles = static_cast<size_t>(particleSystem.GetParticleCount());
+    counters.particleBytes = counters.particles * PARTICLE_BYTES +
+                             static_cast<size_t>(particleSystem.GetContactCount()) * sizeof(b2ParticleContact) +
+                             static_cast<size_t>(particleSystem.GetBodyContactCount()) *
+                             sizeof(b2ParticleBodyContact);
+
+    counters.peakBytes = std::max(counters.peakBytes, counters.totalBytes());
+}
+
+std::ostream &operator<<(std::ostream &out, const MemoryCounters &counters) {
+    const double kib = 1024.0;
+    out << "creatures " << counters.creatures << " (" << counters.creatureBytes / kib << " KiB)"
+        << ", user data " << counters.userDataBytes / kib << " KiB"
+        << ", bodies " << counters.bodies << " (" << counters.bodyBytes / kib << " KiB)"
+        << ", fixtures " << counters.fixtures << " (" << counters.fixtureBytes / kib << " KiB)"
+        << ", contacts " << counters.contacts << " (" << counters.contactBytes / kib << " KiB)"
+        << ", particles " << counters.particles << " (" << counters.particleBytes / kib << " KiB)"
+        << ", total " << counters.totalBytes() / kib << " KiB, peak " << counters.peakBytes / kib << " KiB";
+    return out;
+}
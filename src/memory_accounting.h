@@ -0,0 +1,68 @@
+#ifndef LIQUIDFUN_EVO_SIM_MEMORY_ACCOUNTING_H
+#define LIQUIDFUN_EVO_SIM_MEMORY_ACCOUNTING_H
+
+#include <Box2D/Box2D.h>
+#include <Box2D/Particle/b2ParticleSystem.h>
+#include <cstddef>
+#include <iosfwd>
+#include "creature.h"
+
+// Live bytes held per subsystem. Box2D objects are counted at the size of the block allocator class they
+// land in; malloc overhead and allocator slack are not included.
+struct MemoryCounters {
+    size_t creatures = 0;
+    size_t bodies = 0;
+    size_t fixtures = 0;
+    size_t contacts = 0;
+    size_t particles = 0;
+
+    size_t creatureBytes = 0; // Creature objects, their body lists and creatureList nodes
+    size_t userDataBytes = 0; // BodyData
+    size_t bodyBytes = 0;     // b2Body
+    size_t fixtureBytes = 0;  // b2Fixture, its cloned shape, broad-phase proxy and tree node
+    size_t contactBytes = 0;  // body-body contacts
+    size_t particleBytes = 0; // particle buffers and particle contacts
+
+    size_t peakBytes = 0;
+
+    size_t totalBytes() const {
+        return creatureBytes + userDataBytes + bodyBytes + fixtureBytes + contactBytes + particleBytes;
+    }
+
+    // The part of totalBytes that evicting creatures can give back: everything but contacts and particles
+    size_t creatureTotalBytes() const { return creatureBytes + userDataBytes + bodyBytes + fixtureBytes; }
+};
+
+// What a single creature accounts for; fixed for its lifetime since body parts never change after birth.
+struct CreatureFootprint {
+    size_t bodies = 0;
+    size_t fixtures = 0;
+    size_t creatureBytes = 0;
+    size_t userDataBytes = 0;
+    size_t bodyBytes = 0;
+    size_t fixtureBytes = 0;
+
+    size_t totalBytes() const { return creatureBytes + userDataBytes + bodyBytes + fixtureBytes; }
+};
+
+CreatureFootprint measureCreature(const Creature *creature);
+
+// Running totals, kept up to date on birth and death instead of walking the world.
+class MemoryAccounting {
+public:
+    void onCreatureBorn(const Creature *creature);
+
+    void onCreatureDied(const Creature *creature);
+
+    // Refreshes contact and particle counts from the world; O(1).
+    void update(const b2World &world, const b2ParticleSystem &particleSystem);
+
+    const MemoryCounters &getCounters() const { return counters; }
+
+private:
+    MemoryCounters counters;
+};
+
+std::ostream &operator<<(std::ostream &out, const MemoryCounters &counters);
+
+#endif //LIQUIDFUN_EVO_SIM_MEMORY_ACCOUNTING_H
@@ -0,0 +1,278 @@
+#include "memory_mapping.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::string sharedName(const std::string &name) {
+#ifdef _WIN32
+        return name[0] == '/' ? name.substr(1) : name;
+#else
+        // POSIX shared memory names must start with a single slash
+        return name[0] == '/' ? name : "/" + name;
+#endif
+    }
+
+    std::string lastError() {
+#ifdef _WIN32
+        return std::to_string(GetLastError());
+#else
+        return strerror(errno);
+#endif
+    }
+}
+
+MemoryMapping::~MemoryMapping() {
+    close();
+}
+
+bool MemoryMapping::createFile(const std::string &path, size_t initialSize) {
+    close();
+    name = path;
+    writable = true;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(name.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle != INVALID_HANDLE_VALUE) {
+        file = handle;
+    }
+#else
+    descriptor = ::open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+#endif
+    if (!file && descriptor < 0) {
+        std::cerr << "Failed to create " << name << ": " << lastError() << std::endl;
+        return false;
+    }
+
+    size = initialSize;
+    if (!map()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MemoryMapping::openFile(const std::string &path) {
+    close();
+    name = path;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    bool opened = handle != INVALID_HANDLE_VALUE && GetFileSizeEx(handle, &fileSize);
+    if (handle != INVALID_HANDLE_VALUE) {
+        file = handle;
+    }
+    size = opened ? static_cast<size_t>(fileSize.QuadPart) : 0;
+#else
+    descriptor = ::open(name.c_str(), O_RDONLY);
+    struct stat status;
+    bool opened = descriptor >= 0 && fstat(descriptor, &status) == 0;
+    size = opened ? static_cast<size_t>(status.st_size) : 0;
+#endif
+    if (!opened) {
+        std::cerr << "Failed to open " << name << ": " << lastError() << std::endl;
+        close();
+        return false;
+    }
+
+    usedSize = size;
+    if (size == 0 || !map()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MemoryMapping::createShared(const std::string &regionName, size_t regionSize) {
+    close();
+    name = sharedName(regionName);
+    writable = true;
+    shared = true;
+    size = regionSize;
+    usedSize = regionSize;
+
+#ifdef _WIN32
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                 static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                 static_cast<DWORD>(size), name.c_str());
+    bool created = mapping != nullptr;
+#else
+    descriptor = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    bool created = descriptor >= 0;
+#endif
+    if (!created) {
+        std::cerr << "Failed to create shared memory " << name << ": " << lastError() << std::endl;
+        return false;
+    }
+
+    owner = true;
+    if (!map()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MemoryMapping::openShared(const std::string &regionName) {
+    close();
+    name = sharedName(regionName);
+    shared = true;
+
+#ifdef _WIN32
+    mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+    if (!mapping) {
+        return false;
+    }
+    // Size 0 maps the whole region; map() looks up how big that was
+    size = 0;
+#else
+    descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+    struct stat status;
+    if (descriptor < 0 || fstat(descriptor, &status) != 0) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(status.st_size);
+#endif
+
+    usedSize = size;
+    if (!map()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MemoryMapping::grow(size_t newSize) {
+    if (!writable || shared || newSize <= size) {
+        return writable;
+    }
+    unmap();
+    size = newSize;
+    return map();
+}
+
+bool MemoryMapping::map() {
+    // Readers of shared memory poll and expect to fail until the writer is up
+    bool report = writable || !shared;
+
+#ifdef _WIN32
+    if (!mapping) {
+        // Mapping a writable file beyond its end extends it
+        mapping = CreateFileMappingA(static_cast<HANDLE>(file), nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                     static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                     static_cast<DWORD>(size), nullptr);
+        if (!mapping) {
+            std::cerr << "CreateFileMapping failed for " << name << ": " << GetLastError() << std::endl;
+            return false;
+        }
+    }
+    data = MapViewOfFile(static_cast<HANDLE>(mapping), writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+    if (!data) {
+        if (report) {
+            std::cerr << "MapViewOfFile failed for " << name << ": " << GetLastError() << std::endl;
+        }
+        return false;
+    }
+    if (size == 0) {
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(data, &info, sizeof(info));
+        size = info.RegionSize;
+        usedSize = size;
+    }
+#else
+    if (writable && ftruncate(descriptor, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Failed to resize " << name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    void *mapped = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, descriptor, 0);
+    if (mapped == MAP_FAILED) {
+        if (report) {
+            std::cerr << "Failed to map " << name << ": " << strerror(errno) << std::endl;
+        }
+        return false;
+    }
+    data = mapped;
+#endif
+    return true;
+}
+
+void MemoryMapping::unmap() {
+#ifdef _WIN32
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping) {
+        CloseHandle(static_cast<HANDLE>(mapping));
+    }
+    mapping = nullptr;
+#else
+    if (data) {
+        munmap(data, size);
+    }
+#endif
+    data = nullptr;
+}
+
+void MemoryMapping::flush() {
+    if (!data || !writable) {
+        return;
+    }
+#ifdef _WIN32
+    FlushViewOfFile(data, 0);
+#else
+    msync(data, size, MS_ASYNC);
+#endif
+}
+
+void MemoryMapping::close() {
+    unmap();
+
+    bool trim = writable && !shared;
+#ifdef _WIN32
+    if (file) {
+        if (trim) {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(usedSize);
+            SetFilePointerEx(static_cast<HANDLE>(file), end, nullptr, FILE_BEGIN);
+            SetEndOfFile(static_cast<HANDLE>(file));
+        }
+        CloseHandle(static_cast<HANDLE>(file));
+    }
+#else
+    if (descriptor >= 0) {
+        if (trim && ftruncate(descriptor, static_cast<off_t>(usedSize)) != 0) {
+            std::cerr << "Failed to trim " << name << ": " << strerror(errno) << std::endl;
+        }
+        ::close(descriptor);
+    }
+    if (owner) {
+        shm_unlink(name.c_str());
+    }
+#endif
+
+    size = 0;
+    usedSize = 0;
+    writable = false;
+    shared = false;
+    owner = false;
+    file = nullptr;
+    descriptor = -1;
+}
@@ -0,0 +1,67 @@
+#ifndef LIQUIDFUN_EVO_SIM_MEMORY_MAPPING_H
+#define LIQUIDFUN_EVO_SIM_MEMORY_MAPPING_H
+
+#include <cstddef>
+#include <string>
+
+// Maps a file or a named shared memory object into memory: mmap and shm_open on Linux/macOS, file
+// mappings on Windows. Writable file mappings can grow and are trimmed back to the bytes actually used
+// when closed; shared memory created here is removed again when closed.
+class MemoryMapping {
+public:
+    MemoryMapping() : data(nullptr), size(0), usedSize(0), writable(false), shared(false), owner(false),
+                      file(nullptr), mapping(nullptr), descriptor(-1) {}
+
+    ~MemoryMapping();
+
+    MemoryMapping(const MemoryMapping &) = delete;
+
+    MemoryMapping &operator=(const MemoryMapping &) = delete;
+
+    // Creates (or truncates) the file with room for `initialSize` bytes.
+    bool createFile(const std::string &path, size_t initialSize);
+
+    bool openFile(const std::string &path);
+
+    // Creates the named region, taking over one a crashed run left behind.
+    bool createShared(const std::string &name, size_t size);
+
+    // Read-only. Quiet on failure, since readers poll for regions that may not exist yet.
+    bool openShared(const std::string &name);
+
+    // Remaps a writable file with room for at least `newSize` bytes. Pointers into the old mapping
+    // become invalid.
+    bool grow(size_t newSize);
+
+    // Size a writable file is trimmed to on close
+    void setUsedSize(size_t bytes) { usedSize = bytes; }
+
+    // Asks the OS to write dirty pages back now rather than whenever it gets round to it.
+    void flush();
+
+    void close();
+
+    void *getData() const { return data; }
+
+    size_t getSize() const { return size; }
+
+    bool isWritable() const { return writable; }
+
+private:
+    bool map();
+
+    void unmap();
+
+    std::string name;
+    void *data;
+    size_t size;
+    size_t usedSize;
+    bool writable;
+    bool shared;
+    bool owner;
+    void *file;
+    void *mapping;
+    int descriptor;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_MEMORY_MAPPING_H
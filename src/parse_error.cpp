@@ -0,0 +1,7 @@
+#include "parse_error.h"
+#include <iostream>
+
+bool parseError(const std::string &path, int lineNumber, const std::string &message) {
+    std::cerr << path << ":" << lineNumber << ": " << message << std::endl;
+    return false;
+}
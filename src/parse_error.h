@@ -0,0 +1,10 @@
+#ifndef LIQUIDFUN_EVO_SIM_PARSE_ERROR_H
+#define LIQUIDFUN_EVO_SIM_PARSE_ERROR_H
+
+#include <string>
+
+// Reports a problem in a line-based text file (creature designs, sweep specs) as "path:line: message" on
+// std::cerr. Always returns false, so readers can `return parseError(...)`.
+bool parseError(const std::string &path, int lineNumber, const std::string &message);
+
+#endif //LIQUIDFUN_EVO_SIM_PARSE_ERROR_H
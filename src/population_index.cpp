@@ -0,0 +1,149 @@
+#include "population_index.h"
+#include <algorithm>
+#include <queue>
+
+constexpr float PopulationIndex::HEALTH_BUCKET_WIDTH;
+const size_t PopulationIndex::HEALTH_BUCKETS;
+const size_t PopulationIndex::BODY_PART_BUCKETS;
+
+void BucketCounter::add(size_t bucket, long delta) {
+    counts[bucket] += delta;
+    total += delta;
+    for (size_t i = bucket + 1; i < tree.size(); i += i & (~i + 1)) {
+        tree[i] += delta;
+    }
+}
+
+size_t BucketCounter::countBelow(size_t bucket) const {
+    long sum = 0;
+    for (size_t i = std::min(bucket, counts.size()); i > 0; i -= i & (~i + 1)) {
+        sum += tree[i];
+    }
+    return static_cast<size_t>(sum);
+}
+
+PopulationIndex::PopulationIndex(EvictionPolicy policy)
+        : evictionHeap(evictionOrder(policy), 0), healthiestHeap(higherHealthFirst, 1),
+          healthHistogram(HEALTH_BUCKETS), bodyPartHistogram(BODY_PART_BUCKETS), healthSum(0.0), bodyPartSum(0) {}
+
+PopulationIndex::~PopulationIndex() {
+    for (size_t i = 0; i < healthiestHeap.size(); ++i) {
+        healthiestHeap.at(i)->index = nullptr;
+    }
+}
+
+void PopulationIndex::add(Creature *creature) {
+    if (creature->index) {
+        return;
+    }
+    creature->index = this;
+    evictionHeap.push(creature);
+    healthiestHeap.push(creature);
+
+    size_t parts = creature->getBodyParts().size();
+    healthHistogram.add(healthBucket(creature->getHealth()), 1);
+    bodyPartHistogram.add(bodyPartBucket(parts), 1);
+    healthSum += creature->getHealth();
+    bodyPartSum += parts;
+}
+
+void PopulationIndex::remove(Creature *creature) {
+    if (creature->index != this) {
+        return;
+    }
+    evictionHeap.remove(creature);
+    healthiestHeap.remove(creature);
+    creature->index = nullptr;
+
+    size_t parts = creature->getBodyParts().size();
+    healthHistogram.add(healthBucket(creature->getHealth()), -1);
+    bodyPartHistogram.add(bodyPartBucket(parts), -1);
+    healthSum -= creature->getHealth();
+    bodyPartSum -= parts;
+}
+
+void PopulationIndex::onHealthChanged(Creature *creature, float previousHealth) {
+    healthSum += static_cast<double>(creature->getHealth()) - previousHealth;
+
+    size_t previousBucket = healthBucket(previousHealth);
+    size_t bucket = healthBucket(creature->getHealth());
+    if (bucket != previousBucket) {
+        healthHistogram.add(previousBucket, -1);
+        healthHistogram.add(bucket, 1);
+    }
+
+    evictionHeap.update(creature);
+    healthiestHeap.update(creature);
+}
+
+void PopulationIndex::onHealthChanged(const std::vector<Creature *> &creatures,
+                                      const std::vector<float> &previousHealth) {
+    for (size_t i = 0; i < creatures.size(); ++i) {
+        const Creature *creature = creatures[i];
+        if (creature->index != this) {
+            continue;
+        }
+        healthSum += static_cast<double>(creature->getHealth()) - previousHealth[i];
+
+        size_t previousBucket = healthBucket(previousHealth[i]);
+        size_t bucket = healthBucket(creature->getHealth());
+        if (bucket != previousBucket) {
+            healthHistogram.add(previousBucket, -1);
+            healthHistogram.add(bucket, 1);
+        }
+    }
+
+    evictionHeap.rebuild();
+    healthiestHeap.rebuild();
+}
+
+void PopulationIndex::onBodyPartAdded(Creature *creature) {
+    size_t parts = creature->getBodyParts().size();
+    bodyPartHistogram.add(bodyPartBucket(parts - 1), -1);
+    bodyPartHistogram.add(bodyPartBucket(parts), 1);
+    ++bodyPartSum;
+}
+
+void PopulationIndex::healthiest(size_t n, std::vector<Creature *> &creatures) const {
+    creatures.clear();
+    if (healthiestHeap.empty()) {
+        return;
+    }
+
+    // Best-first walk down the heap: the next healthiest is always the root or a child of one already
+    // taken, so only a frontier of at most n + 1 candidates is ever looked at
+    auto worse = [this](size_t a, size_t b) {
+        return healthiestHeap.before(healthiestHeap.at(b), healthiestHeap.at(a));
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(worse)> frontier(worse);
+    frontier.push(0);
+
+    while (!frontier.empty() && creatures.size() < n) {
+        size_t position = frontier.top();
+        frontier.pop();
+        creatures.push_back(healthiestHeap.at(position));
+
+        for (size_t child = position * 2 + 1; child <= position * 2 + 2 && child < healthiestHeap.size(); ++child) {
+            frontier.push(child);
+        }
+    }
+}
+
+size_t PopulationIndex::countWithBodyPartsAtLeast(size_t parts) const {
+    return bodyPartHistogram.countAtLeast(bodyPartBucket(parts));
+}
+
+size_t PopulationIndex::countWithHealthAtLeast(float health) const {
+    return healthHistogram.countAtLeast(healthBucket(health));
+}
+
+size_t PopulationIndex::healthBucket(float health) {
+    if (!(health > 0.0f)) {
+        return 0;
+    }
+    return std::min(static_cast<size_t>(health / HEALTH_BUCKET_WIDTH), HEALTH_BUCKETS - 1);
+}
+
+size_t PopulationIndex::bodyPartBucket(size_t parts) {
+    return std::min(parts, BODY_PART_BUCKETS - 1);
+}
@@ -0,0 +1,106 @@
+#ifndef LIQUIDFUN_EVO_SIM_POPULATION_INDEX_H
+#define LIQUIDFUN_EVO_SIM_POPULATION_INDEX_H
+
+#include <cstddef>
+#include <vector>
+#include "creature.h"
+#include "eviction.h"
+
+// Counts per bucket plus a Fenwick tree over them, so tail counts are O(log buckets) instead of a walk.
+class BucketCounter {
+public:
+    explicit BucketCounter(size_t buckets) : counts(buckets, 0), tree(buckets + 1, 0), total(0) {}
+
+    void add(size_t bucket, long delta);
+
+    size_t getBuckets() const { return counts.size(); }
+
+    size_t getTotal() const { return total; }
+
+    size_t count(size_t bucket) const { return counts[bucket]; }
+
+    // Entries in buckets [0, bucket)
+    size_t countBelow(size_t bucket) const;
+
+    size_t countAtLeast(size_t bucket) const { return total - countBelow(bucket); }
+
+private:
+    std::vector<size_t> counts;
+    std::vector<long> tree;
+    size_t total;
+};
+
+// Population statistics kept up to date as creatures are born, die and change health, so the HUD,
+// telemetry and eviction can ask without walking creatureList. Creatures report their own health changes
+// through the pointer the index leaves in them.
+class PopulationIndex {
+public:
+    // Health histogram buckets are this wide; the last one also holds everything above it
+    static constexpr float HEALTH_BUCKET_WIDTH = 10.0f;
+    static const size_t HEALTH_BUCKETS = 64;
+    // Body part histogram has one bucket per count; the last one also holds bigger creatures
+    static const size_t BODY_PART_BUCKETS = 32;
+
+    explicit PopulationIndex(EvictionPolicy policy);
+
+    // Detaches any creatures still in the index
+    ~PopulationIndex();
+
+    PopulationIndex(const PopulationIndex &) = delete;
+
+    PopulationIndex &operator=(const PopulationIndex &) = delete;
+
+    void add(Creature *creature);
+
+    void remove(Creature *creature);
+
+    void onHealthChanged(Creature *creature, float previousHealth);
+
+    // onHealthChanged for a whole batch, e.g. a tick's metabolism: the sum and histogram are updated per
+    // creature, but the heaps are rebuilt once instead of re-sifted for every entry.
+    void onHealthChanged(const std::vector<Creature *> &creatures, const std::vector<float> &previousHealth);
+
+    void onBodyPartAdded(Creature *creature);
+
+    size_t size() const { return healthiestHeap.size(); }
+
+    double getHealthSum() const { return healthSum; }
+
+    double getMeanHealth() const { return size() ? healthSum / size() : 0.0; }
+
+    size_t getBodyPartSum() const { return bodyPartSum; }
+
+    double getMeanBodyParts() const { return size() ? static_cast<double>(bodyPartSum) / size() : 0.0; }
+
+    // nullptr when empty
+    Creature *healthiest() const { return healthiestHeap.top(); }
+
+    // The n healthiest creatures, healthiest first. O(n log n) regardless of population size.
+    void healthiest(size_t n, std::vector<Creature *> &creatures) const;
+
+    size_t countWithBodyPartsAtLeast(size_t parts) const;
+
+    // Counted by whole histogram buckets: `health` is rounded down to a multiple of HEALTH_BUCKET_WIDTH.
+    size_t countWithHealthAtLeast(float health) const;
+
+    const BucketCounter &getHealthHistogram() const { return healthHistogram; }
+
+    const BucketCounter &getBodyPartHistogram() const { return bodyPartHistogram; }
+
+    // Creatures in eviction order. Evicted creatures leave this heap but stay in the index until they die.
+    CreatureHeap &getEvictionHeap() { return evictionHeap; }
+
+private:
+    static size_t healthBucket(float health);
+
+    static size_t bodyPartBucket(size_t parts);
+
+    CreatureHeap evictionHeap;
+    CreatureHeap healthiestHeap; // also the list of every creature in the index
+    BucketCounter healthHistogram;
+    BucketCounter bodyPartHistogram;
+    double healthSum;
+    size_t bodyPartSum;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_POPULATION_INDEX_H
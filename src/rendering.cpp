@@ -2,10 +2,12 @@
 // Created by rwill on 4/14/2023.
 //
 #include <GL/glew.h>
+#include <algorithm>
 #include <iostream>
 #include <Box2D/Box2D.h>
 #include <Box2D/Particle/b2ParticleSystem.h>
 #include "rendering.h"
+#include "fluid_density.h"
 // Include necessary headers
 #include <iostream>
 
@@ -19,6 +21,17 @@ float cameraX = 0.0f;
 float cameraY = 0.0f;
 // Keyboard state
 bool keys[GLFW_KEY_LAST] = {false};
+// Set on press, cleared by consumeKeyPress
+bool keysPressed[GLFW_KEY_LAST] = {false};
+
+// Fluid rendering: particles are splatted into a density grid and drawn as one texture instead of points
+const int FLUID_GRID_RESOLUTION = 256;
+const float FLUID_DENSITY_THRESHOLD = 1.0f;
+bool fluidRenderingEnabled = true;
+FluidDensityGrid *fluidGrid = nullptr;
+float fluidGridWorldSize = 0.0f; // the grid maps this world size onto its cells
+std::vector<uint8_t> fluidPixels;
+GLuint fluidTexture = 0;
 
 
 // Function prototypes
@@ -37,40 +50,6 @@ const char *passThroughVertexShaderSource = R"(
 )";
 
 
-const char *passThroughFragmentShaderSource = R"(
-    #version 120
-    void main() {
-float Pi = 6.28318530718; // Pi*2
-
-    // GAUSSIAN BLUR SETTINGS {{{
-    float Directions = 16.0; // BLUR DIRECTIONS (Default 16.0 - More is better but slower)
-    float Quality = 3.0; // BLUR QUALITY (Default 4.0 - More is better but slower)
-    float Size = 8.0; // BLUR SIZE (Radius)
-    // GAUSSIAN BLUR SETTINGS }}}
-
-    vec2 Radius = Size/iResolution.xy;
-
-    // Normalized pixel coordinates (from 0 to 1)
-    vec2 uv = fragCoord/iResolution.xy;
-    // Pixel colour
-    vec4 Color = texture(iChannel0, uv);
-
-    // Blur calculations
-    for( float d=0.0; d<Pi; d+=Pi/Directions)
-    {
-		for(float i=1.0/Quality; i<=1.0; i+=1.0/Quality)
-        {
-			Color += texture( iChannel0, uv+vec2(cos(d),sin(d))*Radius*i);
-        }
-    }
-
-    // Output to screen
-    Color /= Quality * Directions - 15.0;
-    fragColor =  Color;
-        gl_FragColor = vec4(0, 0, 1, 1); // Set a fixed color for particles (blue)
-    }
-)";
-
 const char *testfragmentShaderSource = R"(
     #version 120
     uniform sampler2D uTexture;
@@ -87,13 +66,29 @@ GLuint fragmentShader;
 GLuint shaderProgram;
 
 void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    if (key < 0 || key >= GLFW_KEY_LAST) {
+        return;
+    }
+
     if (action == GLFW_PRESS) {
         keys[key] = true;
+        keysPressed[key] = true;
+
+        // F toggles between the fluid texture and plain particle points
+        if (key == GLFW_KEY_F) {
+            fluidRenderingEnabled = !fluidRenderingEnabled;
+        }
     } else if (action == GLFW_RELEASE) {
         keys[key] = false;
     }
 }
 
+bool consumeKeyPress(int key) {
+    bool pressed = keysPressed[key];
+    keysPressed[key] = false;
+    return pressed;
+}
+
 void updateCamera() {
     float cameraSpeed = 0.1f; // Adjust this value to change the camera movement speed
 
@@ -215,6 +210,63 @@ void cleanUpScene() {
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
     glDeleteProgram(shaderProgram);
+
+    if (fluidTexture != 0) {
+        glDeleteTextures(1, &fluidTexture);
+        fluidTexture = 0;
+    }
+    delete fluidGrid;
+    fluidGrid = nullptr;
+}
+
+void drawFluid(const b2Vec2 *positions, int particleCount, float worldSize) {
+    // A reattached viewer or a newly opened replay can have a different world size
+    if (!fluidGrid || worldSize != fluidGridWorldSize) {
+        delete fluidGrid;
+        fluidGrid = new FluidDensityGrid(FLUID_GRID_RESOLUTION, FLUID_GRID_RESOLUTION, worldSize);
+        fluidGridWorldSize = worldSize;
+    }
+
+    ThreadPool &pool = sharedThreadPool();
+    fluidGrid->splat(positions, particleCount, pool);
+    fluidGrid->blur(pool);
+    fluidGrid->toRGBA(fluidPixels, FLUID_DENSITY_THRESHOLD, pool);
+
+    if (fluidTexture == 0) {
+        glGenTextures(1, &fluidTexture);
+        glBindTexture(GL_TEXTURE_2D, fluidTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, fluidGrid->getWidth(), fluidGrid->getHeight(), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, fluidPixels.data());
+    } else {
+        glBindTexture(GL_TEXTURE_2D, fluidTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fluidGrid->getWidth(), fluidGrid->getHeight(),
+                        GL_RGBA, GL_UNSIGNED_BYTE, fluidPixels.data());
+    }
+
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(1, 1, 1, 1);
+
+    // The grid covers the whole world, so a single quad is enough
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 0);
+    glVertex2f(0, 0);
+    glTexCoord2f(1, 0);
+    glVertex2f(worldSize, 0);
+    glTexCoord2f(1, 1);
+    glVertex2f(worldSize, worldSize);
+    glTexCoord2f(0, 1);
+    glVertex2f(0, worldSize);
+    glEnd();
+
+    glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void drawScene(const std::list<Creature *> &creatureList, b2ParticleSystem *particleSystem, float worldSize) {
@@ -241,10 +293,13 @@ void drawScene(const std::list<Creature *> &creatureList, b2ParticleSystem *part
         }
     }
 
+    if (fluidRenderingEnabled) {
+        drawFluid(particleSystem->GetPositionBuffer(), particleSystem->GetParticleCount(), worldSize);
+        return;
+    }
+
     glPointSize(3.0f);
     glColor3f(0, 0, 1);
-    // Use the shader program
-//    glUseProgram(shaderProgram);
 
     // Draw the particles
     glBegin(GL_POINTS);
@@ -253,10 +308,57 @@ void drawScene(const std::list<Creature *> &creatureList, b2ParticleSystem *part
         glVertex2f(particlePosition.x, particlePosition.y);
     }
     glEnd();
+}
+
+void drawSnapshot(const WorldSnapshot &snapshot) {
+    drawSnapshotData(snapshot.polygons.data(), snapshot.polygons.size(), snapshot.particles.data(),
+                     snapshot.particles.size(), snapshot.worldSize);
+}
+
+void drawSnapshotData(const SnapshotPolygon *polygons, size_t polygonCount, const b2Vec2 *particles,
+                      size_t particleCount, float worldSize) {
+
+    updateCamera();
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glTranslatef(-cameraX, -cameraY, 0);
+
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
 
-    // Disable the shader program
-//    glUseProgram(0);
+    glColor3f(0, 0, 0);
+    drawWorldBoundaries(worldSize);
 
+    for (size_t p = 0; p < polygonCount; ++p) {
+        const SnapshotPolygon &polygon = polygons[p];
+        glColor3f(polygon.r, (polygon.g * polygon.health) / 200, polygon.b);
+
+        glPushMatrix();
+        glTranslatef(polygon.position.x, polygon.position.y, 0);
+        glRotatef(polygon.angle * 180.0f / M_PI, 0, 0, 1);
+        // Read once and clamp: a ring slot being rewritten under us can hold any count
+        int vertexCount = std::min(std::max(polygon.vertexCount, 0), b2_maxPolygonVertices);
+        glBegin(GL_POLYGON);
+        for (int i = 0; i < vertexCount; ++i) {
+            glVertex2f(polygon.vertices[i].x, polygon.vertices[i].y);
+        }
+        glEnd();
+        glPopMatrix();
+    }
+
+    if (fluidRenderingEnabled) {
+        drawFluid(particles, static_cast<int>(particleCount), worldSize);
+        return;
+    }
+
+    glPointSize(3.0f);
+    glColor3f(0, 0, 1);
+    glBegin(GL_POINTS);
+    for (size_t i = 0; i < particleCount; ++i) {
+        glVertex2f(particles[i].x, particles[i].y);
+    }
+    glEnd();
 }
 
 // Create and compile a shader
@@ -6,6 +6,7 @@
 #define LIQUIDFUN_EVO_SIM_RENDERING_H
 
 #include "creature.h"
+#include "world_snapshot.h"
 #include <vector>
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
@@ -17,6 +18,22 @@
 void cleanUpScene();
 void drawScene(const std::list<Creature *> &creatureList, b2ParticleSystem *particleSystem, float worldSize);
 void drawCreature(const b2Body *body, float d);
+void drawFluid(const b2Vec2 *positions, int particleCount, float worldSize);
+// Draws a recorded or captured state of the world instead of the live one
+void drawSnapshot(const WorldSnapshot &snapshot);
+// Same as drawSnapshot, straight from arrays (e.g. a shared memory ring slot). The counts must fit the arrays
+// (SnapshotRingReader::beginRead clamps them); vertex counts are clamped here since a slot can tear mid-draw.
+void drawSnapshotData(const SnapshotPolygon *polygons, size_t polygonCount, const b2Vec2 *particles,
+                      size_t particleCount, float worldSize);
+// True once per key press since the last call
+bool consumeKeyPress(int key);
 GLFWwindow* initGLFW();
 
+// Renderer policy for Simulation<Config>: draws the live world into the current GL context
+struct GLRenderer {
+    void draw(const std::list<Creature *> &creatureList, b2ParticleSystem *particleSystem, float worldSize) {
+        drawScene(creatureList, particleSystem, worldSize);
+    }
+};
+
 #endif //LIQUIDFUN_EVO_SIM_RENDERING_H
@@ -0,0 +1,734 @@
+#include "replay.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    const char FILE_MAGIC[8] = {'E', 'V', 'O', 'R', 'E', 'P', 'L', '1'};
+    const char INDEX_MAGIC[8] = {'E', 'V', 'O', 'I', 'N', 'D', 'E', 'X'};
+    const size_t HEADER_SIZE = 20;
+    const size_t FRAME_HEADER_SIZE = 5;
+    const size_t FOOTER_SIZE = 16;
+
+    const uint8_t FRAME_DELTA = 0;
+    const uint8_t FRAME_KEY = 1;
+    const uint8_t FRAME_INDEX = 2;
+
+    // Quantization steps, in units per world unit / radian / health point
+    const float POSITION_SCALE = 1024.0f;
+    const float ANGLE_SCALE = 4096.0f;
+    const float HEALTH_SCALE = 16.0f;
+    const float PARTICLE_SCALE = 256.0f;
+
+    int seekFile(FILE *file, uint64_t offset) {
+#ifdef _WIN32
+        return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+    }
+
+    uint64_t fileSize(FILE *file) {
+#ifdef _WIN32
+        _fseeki64(file, 0, SEEK_END);
+        return static_cast<uint64_t>(_ftelli64(file));
+#else
+        fseeko(file, 0, SEEK_END);
+        return static_cast<uint64_t>(ftello(file));
+#endif
+    }
+
+    // Clamped to the int32 range so a diverging body cannot overflow; NaN is stored as 0
+    inline int32_t quantize(float value, float scale) {
+        const float limit = 2147483520.0f; // largest float below 2^31
+        float scaled = value * scale;
+        if (scaled != scaled) {
+            return 0;
+        }
+        return static_cast<int32_t>(std::lround(std::min(std::max(scaled, -limit), limit)));
+    }
+
+    // Body angles accumulate without bound as creatures spin; only the direction matters for drawing, so
+    // wrap to [-pi, pi) first
+    inline int32_t quantizeAngle(float angle) {
+        const double twoPi = 6.283185307179586;
+        double wrapped = angle - twoPi * std::floor((angle + 0.5 * twoPi) / twoPi);
+        return quantize(static_cast<float>(wrapped), ANGLE_SCALE);
+    }
+
+    inline uint32_t zigZag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    inline int32_t unZigZag(uint32_t value) {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    void putVarint(std::vector<uint8_t> &out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    inline void putSigned(std::vector<uint8_t> &out, int32_t value) {
+        putVarint(out, zigZag(value));
+    }
+
+    void putUint32(uint8_t *out, uint32_t value) {
+        out[0] = static_cast<uint8_t>(value);
+        out[1] = static_cast<uint8_t>(value >> 8);
+        out[2] = static_cast<uint8_t>(value >> 16);
+        out[3] = static_cast<uint8_t>(value >> 24);
+    }
+
+    uint32_t getUint32(const uint8_t *in) {
+        return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+               static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+    }
+
+    // Bounds-checked reader over a frame payload. Reads past the end return 0 and set `failed`.
+    struct PayloadReader {
+        const uint8_t *data;
+        size_t size;
+        size_t position;
+        bool failed;
+
+        PayloadReader(const std::vector<uint8_t> &payload)
+                : data(payload.data()), size(payload.size()), position(0), failed(false) {}
+
+        uint8_t byte() {
+            if (position >= size) {
+                failed = true;
+                return 0;
+            }
+            return data[position++];
+        }
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t next = byte();
+                value |= static_cast<uint64_t>(next & 0x7F) << shift;
+                if (!(next & 0x80)) {
+                    return value;
+                }
+            }
+            failed = true;
+            return 0;
+        }
+
+        int32_t signedVarint() {
+            return unZigZag(static_cast<uint32_t>(varint()));
+        }
+    };
+
+    void putShape(std::vector<uint8_t> &out, const ReplayCreatureShape &shape) {
+        putVarint(out, shape.size());
+        for (const ReplayBodyShape &body: shape) {
+            out.push_back(static_cast<uint8_t>(std::min(std::max(body.r, 0.0f), 1.0f) * 255.0f));
+            out.push_back(static_cast<uint8_t>(std::min(std::max(body.g, 0.0f), 1.0f) * 255.0f));
+            out.push_back(static_cast<uint8_t>(std::min(std::max(body.b, 0.0f), 1.0f) * 255.0f));
+            putVarint(out, body.polygons.size());
+            for (const ReplayPolygon &polygon: body.polygons) {
+                out.push_back(static_cast<uint8_t>(polygon.vertexCount));
+                for (int i = 0; i < polygon.vertexCount; ++i) {
+                    putSigned(out, quantize(polygon.vertices[i].x, POSITION_SCALE));
+                    putSigned(out, quantize(polygon.vertices[i].y, POSITION_SCALE));
+                }
+            }
+        }
+    }
+
+    void readShape(PayloadReader &in, ReplayCreatureShape &shape) {
+        shape.resize(std::min<uint64_t>(in.varint(), in.size));
+        for (ReplayBodyShape &body: shape) {
+            body.r = in.byte() / 255.0f;
+            body.g = in.byte() / 255.0f;
+            body.b = in.byte() / 255.0f;
+            body.polygons.resize(std::min<uint64_t>(in.varint(), in.size));
+            for (ReplayPolygon &polygon: body.polygons) {
+                polygon.vertexCount = std::min<int>(in.byte(), b2_maxPolygonVertices);
+                for (int i = 0; i < polygon.vertexCount; ++i) {
+                    polygon.vertices[i].x = in.signedVarint() / POSITION_SCALE;
+                    polygon.vertices[i].y = in.signedVarint() / POSITION_SCALE;
+                }
+            }
+        }
+    }
+
+    void captureCreatureShape(const Creature *creature, ReplayCreatureShape &shape) {
+        for (b2Body *body: creature->getBodyParts()) {
+            ReplayBodyShape bodyShape;
+            auto *bodyData = static_cast<BodyData *>(body->GetUserData());
+            bodyShape.r = bodyData ? bodyData->r : 1.0f;
+            bodyShape.g = bodyData ? bodyData->g : 0.0f;
+            bodyShape.b = bodyData ? bodyData->b : 0.0f;
+
+            for (b2Fixture *fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+                if (fixture->GetType() != b2Shape::e_polygon) {
+                    continue;
+                }
+                auto *polygonShape = static_cast<b2PolygonShape *>(fixture->GetShape());
+                ReplayPolygon polygon;
+                polygon.vertexCount = polygonShape->GetVertexCount();
+                for (int i = 0; i < polygon.vertexCount; ++i) {
+                    polygon.vertices[i] = polygonShape->GetVertex(i);
+                }
+                bodyShape.polygons.push_back(polygon);
+            }
+
+            shape.push_back(bodyShape);
+        }
+    }
+}
+
+ReplayRecorder::ReplayRecorder(const std::string &path, float worldSize, unsigned long keyframeInterval,
+                               unsigned long particleInterval)
+        : path(path), file(fopen(path.c_str(), "wb")), bytesWritten(0), writeFailed(false),
+          keyframeInterval(std::max(1ul, keyframeInterval)), particleInterval(std::max(1ul, particleInterval)),
+          framesSinceKeyframe(0), lastTick(0), stopping(false) {
+    if (!file) {
+        std::cerr << "Failed to open replay file " << path << std::endl;
+        return;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    uint8_t header[HEADER_SIZE];
+    memcpy(header, FILE_MAGIC, 8);
+    memcpy(header + 8, &worldSize, 4);
+    putUint32(header + 12, static_cast<uint32_t>(this->keyframeInterval));
+    putUint32(header + 16, static_cast<uint32_t>(this->particleInterval));
+    writeBytes(header, HEADER_SIZE);
+
+    // Force the first frame to be a keyframe
+    framesSinceKeyframe = this->keyframeInterval;
+
+    writerThread = std::thread(&ReplayRecorder::writerLoop, this);
+}
+
+ReplayRecorder::~ReplayRecorder() {
+    if (!file) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    tickQueued.notify_one();
+    writerThread.join();
+
+    if (writeFailed) {
+        fclose(file);
+        return;
+    }
+
+    // Keyframe table, then a fixed-size footer pointing at it
+    uint64_t indexOffset = bytesWritten;
+    std::vector<uint8_t> index;
+    putVarint(index, lastTick);
+    putVarint(index, keyframeIndex.size());
+    for (const auto &entry: keyframeIndex) {
+        putVarint(index, entry.first);
+        putVarint(index, entry.second);
+    }
+
+    uint8_t frameHeader[FRAME_HEADER_SIZE];
+    frameHeader[0] = FRAME_INDEX;
+    putUint32(frameHeader + 1, static_cast<uint32_t>(index.size()));
+    writeBytes(frameHeader, FRAME_HEADER_SIZE);
+    writeBytes(index.data(), index.size());
+
+    uint8_t footer[FOOTER_SIZE];
+    putUint32(footer, static_cast<uint32_t>(indexOffset));
+    putUint32(footer + 4, static_cast<uint32_t>(indexOffset >> 32));
+    memcpy(footer + 8, INDEX_MAGIC, 8);
+    writeBytes(footer, FOOTER_SIZE);
+
+    if (fclose(file) != 0 && !writeFailed) {
+        std::cerr << "Failed to write replay file " << path << std::endl;
+    }
+}
+
+void ReplayRecorder::recordTick(unsigned long tick, const std::list<Creature *> &creatureList,
+                                b2ParticleSystem *particleSystem) {
+    if (!file || writeFailed) {
+        return;
+    }
+
+    std::unique_ptr<RawTick> raw(new RawTick());
+    raw->tick = tick;
+    raw->hasParticles = tick % particleInterval == 0;
+
+    currentCreatures.clear();
+    for (const Creature *creature: creatureList) {
+        uint32 id = creature->getId();
+        currentCreatures.insert(id);
+
+        raw->creatureIds.push_back(id);
+        raw->health.push_back(creature->getHealth());
+        raw->bodyCounts.push_back(static_cast<uint32>(creature->getBodyParts().size()));
+        for (b2Body *body: creature->getBodyParts()) {
+            raw->positions.push_back(body->GetPosition());
+            raw->angles.push_back(body->GetAngle());
+        }
+
+        // Shapes never change after birth, so they are only copied the first time a creature is seen
+        if (recordedCreatures.count(id) == 0) {
+            raw->births.emplace_back(id, ReplayCreatureShape());
+            captureCreatureShape(creature, raw->births.back().second);
+        }
+    }
+    std::swap(recordedCreatures, currentCreatures);
+
+    if (raw->hasParticles) {
+        const b2Vec2 *positions = particleSystem->GetPositionBuffer();
+        raw->particles.assign(positions, positions + particleSystem->GetParticleCount());
+    }
+
+    // Unlike frame capture, a replay cannot skip ticks, so wait if the writer is far behind
+    std::unique_lock<std::mutex> lock(mutex);
+    tickTaken.wait(lock, [this] { return pendingTicks.size() < MAX_PENDING_TICKS; });
+    pendingTicks.push_back(std::move(raw));
+    lock.unlock();
+    tickQueued.notify_one();
+}
+
+void ReplayRecorder::writerLoop() {
+    std::vector<uint8_t> frame;
+
+    while (true) {
+        std::unique_ptr<RawTick> raw;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            tickQueued.wait(lock, [this] { return stopping || !pendingTicks.empty(); });
+            if (pendingTicks.empty()) {
+                return;
+            }
+            raw = std::move(pendingTicks.front());
+            pendingTicks.pop_front();
+        }
+        tickTaken.notify_one();
+
+        // After a failed write the rest of the queue is only drained
+        if (!writeFailed) {
+            encode(*raw, frame);
+            writeBytes(frame.data(), frame.size());
+        }
+    }
+}
+
+void ReplayRecorder::encode(const RawTick &raw, std::vector<uint8_t> &frame) {
+    bool keyframe = framesSinceKeyframe >= keyframeInterval;
+    framesSinceKeyframe = keyframe ? 1 : framesSinceKeyframe + 1;
+    if (keyframe) {
+        keyframeIndex.emplace_back(raw.tick, bytesWritten);
+    }
+    lastTick = raw.tick;
+
+    // Leave room for the frame header, filled in once the payload size is known
+    frame.assign(FRAME_HEADER_SIZE, 0);
+    putVarint(frame, raw.tick);
+    frame.push_back(raw.hasParticles || keyframe ? 1 : 0);
+
+    std::unordered_set<uint32> born;
+    for (const auto &birth: raw.births) {
+        born.insert(birth.first);
+        EncodedCreature &encoded = encodedCreatures[birth.first];
+        encoded.shape = birth.second;
+    }
+
+    // Deaths: anything from the previous frame that is no longer listed
+    std::unordered_set<uint32> alive(raw.creatureIds.begin(), raw.creatureIds.end());
+    std::vector<uint32> deaths;
+    for (uint32 id: previousOrder) {
+        if (alive.count(id) == 0) {
+            deaths.push_back(id);
+            encodedCreatures.erase(id);
+        }
+    }
+    putVarint(frame, deaths.size());
+    for (uint32 id: deaths) {
+        putVarint(frame, id);
+    }
+
+    putVarint(frame, raw.creatureIds.size());
+    uint32 previousId = 0;
+    size_t bodyIndex = 0;
+    for (size_t i = 0; i < raw.creatureIds.size(); ++i) {
+        uint32 id = raw.creatureIds[i];
+        EncodedCreature &encoded = encodedCreatures[id];
+        bool full = keyframe || born.count(id) != 0;
+
+        putSigned(frame, static_cast<int32_t>(id - previousId));
+        previousId = id;
+        frame.push_back(full ? 1 : 0);
+        if (full) {
+            putShape(frame, encoded.shape);
+        }
+
+        int32_t health = quantize(raw.health[i], HEALTH_SCALE);
+        putSigned(frame, full ? health : health - encoded.health);
+        encoded.health = health;
+
+        uint32 bodyCount = raw.bodyCounts[i];
+        putVarint(frame, bodyCount);
+        if (encoded.transforms.size() != bodyCount * 3) {
+            encoded.transforms.assign(bodyCount * 3, 0);
+        }
+        for (uint32 body = 0; body < bodyCount; ++body, ++bodyIndex) {
+            int32_t values[3] = {quantize(raw.positions[bodyIndex].x, POSITION_SCALE),
+                                 quantize(raw.positions[bodyIndex].y, POSITION_SCALE),
+                                 quantizeAngle(raw.angles[bodyIndex])};
+            for (int k = 0; k < 3; ++k) {
+                int32_t &previous = encoded.transforms[body * 3 + k];
+                putSigned(frame, full ? values[k] : values[k] - previous);
+                previous = values[k];
+            }
+        }
+    }
+    previousOrder = raw.creatureIds;
+
+    // Particles are deltas against the last frame that stored them, matched by index
+    if (raw.hasParticles) {
+        size_t previousCount = keyframe ? 0 : previousParticles.size() / 2;
+        previousParticles.resize(raw.particles.size() * 2);
+        putVarint(frame, raw.particles.size());
+        for (size_t i = 0; i < raw.particles.size(); ++i) {
+            int32_t x = quantize(raw.particles[i].x, PARTICLE_SCALE);
+            int32_t y = quantize(raw.particles[i].y, PARTICLE_SCALE);
+            bool delta = i < previousCount;
+            putSigned(frame, delta ? x - previousParticles[i * 2] : x);
+            putSigned(frame, delta ? y - previousParticles[i * 2 + 1] : y);
+            previousParticles[i * 2] = x;
+            previousParticles[i * 2 + 1] = y;
+        }
+    } else if (keyframe) {
+        // Keyframes must be self-contained, so repeat the held particle state
+        putVarint(frame, previousParticles.size() / 2);
+        for (int32_t value: previousParticles) {
+            putSigned(frame, value);
+        }
+    }
+
+    frame[0] = keyframe ? FRAME_KEY : FRAME_DELTA;
+    putUint32(&frame[1], static_cast<uint32_t>(frame.size() - FRAME_HEADER_SIZE));
+}
+
+void ReplayRecorder::writeBytes(const uint8_t *data, size_t size) {
+    if (writeFailed) {
+        return;
+    }
+    if (fwrite(data, 1, size, file) != size) {
+        // Offsets in the keyframe index would no longer match the file, so stop recording here. What was
+        // written before is still playable by scanning.
+        std::cerr << "Failed to write replay file " << path << ", recording stopped at tick " << lastTick
+                  << std::endl;
+        writeFailed = true;
+        return;
+    }
+    bytesWritten += size;
+}
+
+ReplayPlayer::ReplayPlayer(const std::string &path)
+        : file(fopen(path.c_str(), "rb")), worldSize(0.0f), dataStart(HEADER_SIZE), dataEnd(0),
+          keyframeInterval(0), lastTick(0), currentTick(0), hasFrame(false), birthsInFrame(0), deathsInFrame(0) {
+    if (!file) {
+        std::cerr << "Failed to open replay file " << path << std::endl;
+        return;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    uint8_t header[HEADER_SIZE];
+    if (fread(header, 1, HEADER_SIZE, file) != HEADER_SIZE || memcmp(header, FILE_MAGIC, 8) != 0) {
+        std::cerr << "Not a replay file: " << path << std::endl;
+        fclose(file);
+        file = nullptr;
+        return;
+    }
+    memcpy(&worldSize, header + 8, 4);
+    keyframeInterval = getUint32(header + 12);
+
+    if (!readIndexFooter()) {
+        std::cerr << "Replay has no index (recorder did not shut down cleanly), scanning frames" << std::endl;
+        scanFrames();
+    }
+
+    if (keyframes.empty()) {
+        std::cerr << "Replay contains no frames: " << path << std::endl;
+        fclose(file);
+        file = nullptr;
+        return;
+    }
+
+    seek(keyframes.front().first);
+}
+
+ReplayPlayer::~ReplayPlayer() {
+    if (file) {
+        fclose(file);
+    }
+}
+
+bool ReplayPlayer::readIndexFooter() {
+    uint64_t size = fileSize(file);
+    if (size < HEADER_SIZE + FRAME_HEADER_SIZE + FOOTER_SIZE) {
+        return false;
+    }
+
+    uint8_t footer[FOOTER_SIZE];
+    if (seekFile(file, size - FOOTER_SIZE) != 0 || fread(footer, 1, FOOTER_SIZE, file) != FOOTER_SIZE ||
+        memcmp(footer + 8, INDEX_MAGIC, 8) != 0) {
+        return false;
+    }
+
+    uint64_t indexOffset = getUint32(footer) | static_cast<uint64_t>(getUint32(footer + 4)) << 32;
+    uint8_t frameHeader[FRAME_HEADER_SIZE];
+    if (seekFile(file, indexOffset) != 0 || fread(frameHeader, 1, FRAME_HEADER_SIZE, file) != FRAME_HEADER_SIZE ||
+        frameHeader[0] != FRAME_INDEX) {
+        return false;
+    }
+
+    payload.resize(getUint32(frameHeader + 1));
+    if (fread(payload.data(), 1, payload.size(), file) != payload.size()) {
+        return false;
+    }
+
+    PayloadReader in(payload);
+    lastTick = in.varint();
+    uint64_t count = in.varint();
+    keyframes.clear();
+    for (uint64_t i = 0; i < count && !in.failed; ++i) {
+        uint64_t tick = in.varint();
+        uint64_t offset = in.varint();
+        keyframes.emplace_back(tick, offset);
+    }
+    dataEnd = indexOffset;
+    return !in.failed;
+}
+
+void ReplayPlayer::scanFrames() {
+    keyframes.clear();
+    uint64_t size = fileSize(file);
+    uint64_t offset = dataStart;
+    seekFile(file, offset);
+
+    // Only frame headers and the leading tick are read; payloads are skipped
+    uint8_t frameHeader[FRAME_HEADER_SIZE + 10];
+    while (fread(frameHeader, 1, FRAME_HEADER_SIZE, file) == FRAME_HEADER_SIZE &&
+           (frameHeader[0] == FRAME_DELTA || frameHeader[0] == FRAME_KEY)) {
+        uint32_t length = getUint32(frameHeader + 1);
+        size_t tickBytes = fread(frameHeader + FRAME_HEADER_SIZE, 1, std::min<uint32_t>(length, 10), file);
+        if (tickBytes < std::min<uint32_t>(length, 10)) {
+            break;
+        }
+
+        uint64_t tick = 0;
+        for (size_t i = 0; i < tickBytes; ++i) {
+            tick |= static_cast<uint64_t>(frameHeader[FRAME_HEADER_SIZE + i] & 0x7F) << (7 * i);
+            if (!(frameHeader[FRAME_HEADER_SIZE + i] & 0x80)) {
+                break;
+            }
+        }
+
+        uint64_t next = offset + FRAME_HEADER_SIZE + length;
+        // A truncated last frame is dropped
+        if (next > size) {
+            break;
+        }
+        if (frameHeader[0] == FRAME_KEY) {
+            keyframes.emplace_back(tick, offset);
+        }
+        lastTick = tick;
+        offset = next;
+        seekFile(file, offset);
+    }
+    dataEnd = offset;
+}
+
+bool ReplayPlayer::decodeNextFrame() {
+    uint8_t frameHeader[FRAME_HEADER_SIZE];
+    if (fread(frameHeader, 1, FRAME_HEADER_SIZE, file) != FRAME_HEADER_SIZE ||
+        (frameHeader[0] != FRAME_DELTA && frameHeader[0] != FRAME_KEY)) {
+        return false;
+    }
+
+    payload.resize(getUint32(frameHeader + 1));
+    if (fread(payload.data(), 1, payload.size(), file) != payload.size()) {
+        return false;
+    }
+
+    bool keyframe = frameHeader[0] == FRAME_KEY;
+    if (!keyframe && !hasFrame) {
+        return false;
+    }
+
+    PayloadReader in(payload);
+    unsigned long tick = static_cast<unsigned long>(in.varint());
+    bool hasParticles = in.byte() != 0;
+
+    size_t deaths = static_cast<size_t>(in.varint());
+    for (size_t i = 0; i < deaths && !in.failed; ++i) {
+        in.varint();
+    }
+
+    // Creatures carried over from the previous frame, looked up by id
+    std::unordered_map<uint32, size_t> previousIndex;
+    if (!keyframe) {
+        for (size_t i = 0; i < creatures.size(); ++i) {
+            previousIndex[creatures[i].id] = i;
+        }
+    }
+
+    uint64_t creatureCount = std::min<uint64_t>(in.varint(), in.size);
+    std::vector<DecodedCreature> decoded(creatureCount);
+    const size_t NOT_CARRIED = SIZE_MAX;
+    std::vector<size_t> carriedFrom(creatureCount, NOT_CARRIED);
+    size_t births = 0;
+    uint32 id = 0;
+    for (DecodedCreature &creature: decoded) {
+        id += static_cast<uint32>(in.signedVarint());
+        creature.id = id;
+        bool full = in.byte() != 0;
+
+        if (full) {
+            readShape(in, creature.shape);
+            creature.health = in.signedVarint();
+            if (!keyframe) {
+                ++births;
+            }
+        } else {
+            auto previous = previousIndex.find(id);
+            if (previous == previousIndex.end()) {
+                in.failed = true;
+                break;
+            }
+            carriedFrom[&creature - decoded.data()] = previous->second;
+            creature.health = creatures[previous->second].health + in.signedVarint();
+        }
+
+        // Deltas stay deltas until the whole frame has parsed
+        uint64_t bodyCount = std::min<uint64_t>(in.varint(), in.size);
+        creature.transforms.resize(bodyCount * 3);
+        for (size_t i = 0; i < bodyCount * 3; ++i) {
+            creature.transforms[i] = in.signedVarint();
+        }
+    }
+
+    std::vector<int32_t> decodedParticles;
+    if (hasParticles && !in.failed) {
+        uint64_t particleCount = std::min<uint64_t>(in.varint(), in.size);
+        size_t previousCount = keyframe ? 0 : particles.size() / 2;
+        decodedParticles.resize(particleCount * 2);
+        for (size_t i = 0; i < particleCount * 2; ++i) {
+            int32_t value = in.signedVarint();
+            decodedParticles[i] = i / 2 < previousCount ? particles[i] + value : value;
+        }
+    }
+
+    // A corrupt frame leaves the previous state untouched
+    if (in.failed) {
+        std::cerr << "Corrupt replay frame at tick " << tick << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < decoded.size(); ++i) {
+        if (carriedFrom[i] == NOT_CARRIED) {
+            continue;
+        }
+        DecodedCreature &old = creatures[carriedFrom[i]];
+        decoded[i].shape = std::move(old.shape);
+        for (size_t k = 0; k < decoded[i].transforms.size() && k < old.transforms.size(); ++k) {
+            decoded[i].transforms[k] += old.transforms[k];
+        }
+    }
+    creatures = std::move(decoded);
+    birthsInFrame = births;
+    deathsInFrame = deaths;
+    if (hasParticles) {
+        particles.swap(decodedParticles);
+    }
+    currentTick = tick;
+    hasFrame = true;
+    return true;
+}
+
+bool ReplayPlayer::seek(unsigned long tick) {
+    if (!file || keyframes.empty()) {
+        return false;
+    }
+
+    // Last keyframe at or before the target
+    auto keyframe = std::upper_bound(keyframes.begin(), keyframes.end(),
+                                     std::pair<uint64_t, uint64_t>(tick, UINT64_MAX));
+    if (keyframe != keyframes.begin()) {
+        --keyframe;
+    }
+
+    seekFile(file, keyframe->second);
+    hasFrame = false;
+    if (!decodeNextFrame()) {
+        return false;
+    }
+    while (currentTick < tick && currentTick < lastTick) {
+        if (!decodeNextFrame()) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool ReplayPlayer::advance(unsigned long ticks) {
+    if (!file || !hasFrame || currentTick >= lastTick) {
+        return false;
+    }
+
+    // Decoding from a keyframe beats decoding more than a keyframe interval of deltas
+    if (ticks > keyframeInterval) {
+        return seek(currentTick + ticks);
+    }
+
+    for (unsigned long i = 0; i < ticks; ++i) {
+        if (!decodeNextFrame()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ReplayPlayer::toSnapshot(WorldSnapshot &snapshot) const {
+    snapshot.tick = currentTick;
+    snapshot.worldSize = worldSize;
+    snapshot.polygons.clear();
+
+    for (const DecodedCreature &creature: creatures) {
+        float health = creature.health / HEALTH_SCALE;
+        size_t bodyCount = std::min(creature.shape.size(), creature.transforms.size() / 3);
+
+        for (size_t body = 0; body < bodyCount; ++body) {
+            const ReplayBodyShape &bodyShape = creature.shape[body];
+            for (const ReplayPolygon &replayPolygon: bodyShape.polygons) {
+                SnapshotPolygon polygon;
+                polygon.position.Set(creature.transforms[body * 3] / POSITION_SCALE,
+                                     creature.transforms[body * 3 + 1] / POSITION_SCALE);
+                polygon.angle = creature.transforms[body * 3 + 2] / ANGLE_SCALE;
+                polygon.r = bodyShape.r;
+                polygon.g = bodyShape.g;
+                polygon.b = bodyShape.b;
+                polygon.health = health;
+                polygon.vertexCount = replayPolygon.vertexCount;
+                std::copy(replayPolygon.vertices, replayPolygon.vertices + replayPolygon.vertexCount,
+                          polygon.vertices);
+                snapshot.polygons.push_back(polygon);
+            }
+        }
+    }
+
+    snapshot.particles.resize(particles.size() / 2);
+    for (size_t i = 0; i < snapshot.particles.size(); ++i) {
+        snapshot.particles[i].Set(particles[i * 2] / PARTICLE_SCALE, particles[i * 2 + 1] / PARTICLE_SCALE);
+    }
+}
@@ -0,0 +1,185 @@
+#ifndef LIQUIDFUN_EVO_SIM_REPLAY_H
+#define LIQUIDFUN_EVO_SIM_REPLAY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "creature.h"
+#include "world_snapshot.h"
+
+// Replay files are a header followed by one length-prefixed frame per recorded tick. Creature transforms,
+// health and particle positions are quantized to integers and stored as zig-zag varint deltas against the
+// previous frame. Every keyframeInterval ticks a keyframe stores the full state (shapes included), so a
+// player can seek to any tick by decoding forward from the nearest keyframe. A table of keyframe offsets is
+// appended when the recorder is closed; files cut short by a crash are still playable, just slower to open.
+
+struct ReplayPolygon {
+    int vertexCount;
+    b2Vec2 vertices[b2_maxPolygonVertices]; // body-local
+};
+
+struct ReplayBodyShape {
+    float r, g, b;
+    std::vector<ReplayPolygon> polygons;
+};
+
+typedef std::vector<ReplayBodyShape> ReplayCreatureShape;
+
+// Records ticks to a replay file. recordTick only copies what changed since the last tick (plus the shapes
+// of newly born creatures); quantization, delta encoding and file writes happen on a background thread.
+class ReplayRecorder {
+public:
+    // Particles are stored every particleInterval ticks and held in between during playback.
+    ReplayRecorder(const std::string &path, float worldSize, unsigned long keyframeInterval = 600,
+                   unsigned long particleInterval = 4);
+
+    // Writes out everything still queued and the keyframe index.
+    ~ReplayRecorder();
+
+    ReplayRecorder(const ReplayRecorder &) = delete;
+
+    ReplayRecorder &operator=(const ReplayRecorder &) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    void recordTick(unsigned long tick, const std::list<Creature *> &creatureList,
+                    b2ParticleSystem *particleSystem);
+
+private:
+    struct RawTick {
+        unsigned long tick;
+        bool hasParticles;
+        std::vector<uint32> creatureIds;
+        std::vector<float> health;
+        std::vector<uint32> bodyCounts;
+        std::vector<b2Vec2> positions;
+        std::vector<float> angles;
+        std::vector<std::pair<uint32, ReplayCreatureShape>> births;
+        std::vector<b2Vec2> particles;
+    };
+
+    struct EncodedCreature {
+        ReplayCreatureShape shape;
+        int32_t health;
+        std::vector<int32_t> transforms; // x, y, angle per body
+    };
+
+    void writerLoop();
+
+    void encode(const RawTick &raw, std::vector<uint8_t> &frame);
+
+    void writeBytes(const uint8_t *data, size_t size);
+
+    static const size_t MAX_PENDING_TICKS = 256;
+
+    std::string path;
+    FILE *file;
+    uint64_t bytesWritten;
+
+    // Set by the writer thread on the first short write; recording stops from then on
+    std::atomic<bool> writeFailed;
+
+    unsigned long keyframeInterval;
+    unsigned long particleInterval;
+
+    // Simulation thread only
+    std::unordered_set<uint32> recordedCreatures;
+    std::unordered_set<uint32> currentCreatures;
+
+    // Writer thread only
+    std::unordered_map<uint32, EncodedCreature> encodedCreatures;
+    std::vector<uint32> previousOrder;
+    std::vector<int32_t> previousParticles;
+    std::vector<std::pair<uint64_t, uint64_t>> keyframeIndex; // tick, file offset
+    unsigned long framesSinceKeyframe;
+    unsigned long lastTick;
+
+    std::mutex mutex;
+    std::condition_variable tickQueued;
+    std::condition_variable tickTaken;
+    std::deque<std::unique_ptr<RawTick>> pendingTicks;
+    bool stopping;
+
+    std::thread writerThread;
+};
+
+// Reads a replay file and reconstructs the drawable state at any recorded tick. No physics is involved.
+class ReplayPlayer {
+public:
+    explicit ReplayPlayer(const std::string &path);
+
+    ~ReplayPlayer();
+
+    ReplayPlayer(const ReplayPlayer &) = delete;
+
+    ReplayPlayer &operator=(const ReplayPlayer &) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    float getWorldSize() const { return worldSize; }
+
+    unsigned long getTick() const { return currentTick; }
+
+    unsigned long getFirstTick() const { return keyframes.empty() ? 0 : keyframes.front().first; }
+
+    unsigned long getLastTick() const { return lastTick; }
+
+    unsigned long getKeyframeInterval() const { return keyframeInterval; }
+
+    // Decodes forward by up to `ticks` frames, jumping through a keyframe when that is cheaper. Returns false
+    // at the end of the recording.
+    bool advance(unsigned long ticks);
+
+    // Restores the state at the first recorded tick >= `tick`, or the last tick if the recording ends first.
+    bool seek(unsigned long tick);
+
+    void toSnapshot(WorldSnapshot &snapshot) const;
+
+    // Creatures born/died in the most recently decoded frame
+    size_t getBirthsInFrame() const { return birthsInFrame; }
+
+    size_t getDeathsInFrame() const { return deathsInFrame; }
+
+private:
+    struct DecodedCreature {
+        uint32 id;
+        ReplayCreatureShape shape;
+        int32_t health;
+        std::vector<int32_t> transforms;
+    };
+
+    bool readIndexFooter();
+
+    void scanFrames();
+
+    bool decodeNextFrame();
+
+    FILE *file;
+    float worldSize;
+    uint64_t dataStart;
+    uint64_t dataEnd;
+    unsigned long keyframeInterval;
+
+    std::vector<std::pair<uint64_t, uint64_t>> keyframes; // tick, file offset
+    unsigned long lastTick;
+
+    unsigned long currentTick;
+    bool hasFrame;
+    std::vector<DecodedCreature> creatures;
+    std::vector<int32_t> particles;
+    std::vector<uint8_t> payload;
+    size_t birthsInFrame;
+    size_t deathsInFrame;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_REPLAY_H
@@ -0,0 +1,168 @@
+#include "run_options.h"
+#include "eviction.h"
+#include "genome.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // --capture-size range. Below the minimum the world would be framed in a pixel or two; a square frame at
+    // the maximum is already 192 MB of RGB.
+    const long MIN_CAPTURE_SIZE = 16;
+    const long MAX_CAPTURE_SIZE = 8192;
+}
+
+bool parseRunOptions(int argc, char **argv, RunOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--ticks") == 0 && hasValue) {
+            options.maxTicks = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--capture-dir") == 0 && hasValue) {
+            options.captureDirectory = argv[++i];
+        } else if (strcmp(arg, "--capture-every") == 0 && hasValue) {
+            options.captureInterval = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--capture-size") == 0 && hasValue) {
+            // Sizes the software framebuffer, so reject anything that is not a sensible pixel count
+            const char *size = argv[++i];
+            char *end = nullptr;
+            long pixels = strtol(size, &end, 10);
+            if (end == size || *end != '\0' || pixels < MIN_CAPTURE_SIZE || pixels > MAX_CAPTURE_SIZE) {
+                std::cerr << "Invalid capture size: " << size << " (expected " << MIN_CAPTURE_SIZE << " to "
+                          << MAX_CAPTURE_SIZE << ")" << std::endl;
+                return false;
+            }
+            options.captureSize = static_cast<int>(pixels);
+        } else if (strcmp(arg, "--capture-format") == 0 && hasValue) {
+            const char *format = argv[++i];
+            if (strcmp(format, "png") == 0) {
+                options.captureFormat = CaptureFormat::PNG;
+            } else if (strcmp(format, "ppm") == 0) {
+                options.captureFormat = CaptureFormat::PPM;
+            } else {
+                std::cerr << "Unknown capture format: " << format << std::endl;
+                return false;
+            }
+        } else if (strcmp(arg, "--record") == 0 && hasValue) {
+            options.recordPath = argv[++i];
+        } else if (strcmp(arg, "--keyframe-every") == 0 && hasValue) {
+            options.keyframeInterval = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--replay") == 0 && hasValue) {
+            options.replayPath = argv[++i];
+        } else if (strcmp(arg, "--replay-speed") == 0 && hasValue) {
+            options.replaySpeed = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(arg, "--publish") == 0) {
+            options.publishName = hasValue && argv[i + 1][0] != '-' ? argv[++i] : DEFAULT_SNAPSHOT_RING_NAME;
+        } else if (strcmp(arg, "--publish-every") == 0 && hasValue) {
+            options.publishInterval = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(arg, "--max-population") == 0 && hasValue) {
+            options.params.maxPopulation = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--memory-budget-mb") == 0 && hasValue) {
+            options.params.memoryBudgetBytes = static_cast<size_t>(atof(argv[++i]) * 1024.0 * 1024.0);
+        } else if (strcmp(arg, "--eviction") == 0 && hasValue) {
+            const char *policy = argv[++i];
+            if (!parseEvictionPolicy(policy, options.params.evictionPolicy)) {
+                std::cerr << "Unknown eviction policy: " << policy << std::endl;
+                return false;
+            }
+        } else if (strcmp(arg, "--stats-every") == 0 && hasValue) {
+            options.statsInterval = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--param") == 0 && i + 2 < argc) {
+            const char *name = argv[++i];
+            if (!setSimulationParam(options.params, name, atof(argv[++i]))) {
+                std::cerr << "Unknown parameter: " << name << " (known: " << simulationParamNames() << ")"
+                          << std::endl;
+                return false;
+            }
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            options.threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+            options.params.seed = static_cast<uint32>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(arg, "--lineage") == 0 && hasValue) {
+            options.lineagePath = argv[++i];
+        } else if (strcmp(arg, "--export-designs") == 0 && hasValue) {
+            options.exportDesignsPath = argv[++i];
+        } else {
+            std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void printRunUsage(const char *program) {
+    std::cerr << "Usage: " << program << " [--ticks N] [--capture-dir DIR] [--capture-every N]"
+              << " [--capture-size PIXELS] [--capture-format png|ppm] [--record FILE] [--keyframe-every N]"
+              << " [--replay FILE] [--replay-speed X] [--publish [NAME]] [--publish-every N]"
+              << " [--max-population N] [--memory-budget-mb MB] [--eviction lowest-health|oldest]"
+              << " [--stats-every N] [--export-designs FILE] [--param NAME VALUE] [--seed N]"
+              << " [--lineage FILE] [--threads N]" << std::endl
+              << "--memory-budget-mb counts creature memory only; particles and contacts cannot be evicted"
+              << std::endl;
+}
+
+RunOutputs::RunOutputs(const RunOptions &options) : options(options) {}
+
+bool RunOutputs::open() {
+    float worldSize = options.params.worldSize;
+
+    if (!options.captureDirectory.empty()) {
+        frameCapture.reset(new FrameCapture(options.captureDirectory, options.captureInterval,
+                                            options.captureSize, options.captureSize, options.captureFormat));
+    }
+
+    if (!options.recordPath.empty()) {
+        replayRecorder.reset(new ReplayRecorder(options.recordPath, worldSize, options.keyframeInterval));
+        if (!replayRecorder->isOpen()) {
+            return false;
+        }
+    }
+
+    if (!options.publishName.empty()) {
+        snapshotRing.reset(new SnapshotRingWriter(options.publishName));
+        if (!snapshotRing->isOpen()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RunOutputs::afterTick(unsigned long tick, const std::list<Creature *> &creatureList,
+                           b2ParticleSystem *particleSystem, const FullInstrumentation &instrumentation) {
+    float worldSize = options.params.worldSize;
+
+    if (frameCapture) {
+        frameCapture->captureIfDue(tick, creatureList, particleSystem, worldSize);
+    }
+    if (replayRecorder) {
+        replayRecorder->recordTick(tick, creatureList, particleSystem);
+    }
+    if (snapshotRing && tick % options.publishInterval == 0) {
+        snapshotRing->publish(tick, creatureList, particleSystem, worldSize);
+    }
+
+    if (options.statsInterval != 0 && tick % options.statsInterval == 0) {
+        const PopulationIndex &population = instrumentation.getPopulationIndex();
+        const MemoryCounters &counters = instrumentation.getMemoryAccounting().getCounters();
+        std::cout << "tick " << tick << ": mean health " << population.getMeanHealth() << ", mean body parts "
+                  << population.getMeanBodyParts() << ", " << counters << std::endl;
+    }
+}
+
+void RunOutputs::finish(const std::list<Creature *> &creatureList) {
+    // Finish writing any queued frames
+    frameCapture.reset();
+    replayRecorder.reset();
+    snapshotRing.reset();
+
+    if (!options.exportDesignsPath.empty()) {
+        std::vector<CreatureDesign> designs;
+        for (const Creature *creature: creatureList) {
+            designs.push_back(describeCreature(creature, "creature" + std::to_string(creature->getId())));
+        }
+        writeDesigns(options.exportDesignsPath, designs);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef LIQUIDFUN_EVO_SIM_RUN_OPTIONS_H
+#define LIQUIDFUN_EVO_SIM_RUN_OPTIONS_H
+
+#include <list>
+#include <memory>
+#include <string>
+#include "frame_capture.h"
+#include "replay.h"
+#include "simulation.h"
+#include "snapshot_ring.h"
+
+// Command line shared by liquidfun_evo_sim (windowed) and liquidfun_evo_headless
+struct RunOptions {
+    // Stop after this many ticks (0 runs until the window is closed or the process is killed)
+    unsigned long maxTicks = 0;
+
+    // Software-rendered frames are written here every captureInterval ticks when set
+    std::string captureDirectory;
+    unsigned long captureInterval = 60;
+    int captureSize = 800;
+    CaptureFormat captureFormat = CaptureFormat::PNG;
+
+    // Replay recording of the run, or playback of an earlier recording instead of simulating (windowed only)
+    std::string recordPath;
+    unsigned long keyframeInterval = 600;
+    std::string replayPath;
+    float replaySpeed = 1.0f;
+
+    // Shared memory ring for out-of-process viewers
+    std::string publishName;
+    unsigned long publishInterval = 1;
+
+    // World rules, population limits and eviction policy
+    SimulationParams params;
+
+    // Threads for the per-creature passes of each tick (0 = one per core, 1 = all on the main thread)
+    int threads = 0;
+
+    // Print population and memory counters every N ticks (0 = never)
+    unsigned long statsInterval = 0;
+
+    // Every birth and death is appended here when set
+    std::string lineagePath;
+
+    // Designs of the surviving creatures are written here on exit, for liquidfun_evo_evaluate
+    std::string exportDesignsPath;
+};
+
+// Prints what was wrong and returns false on an unknown or malformed argument
+bool parseRunOptions(int argc, char **argv, RunOptions &options);
+
+void printRunUsage(const char *program);
+
+// Everything a run writes apart from the window: captured frames, the replay recording, the published
+// snapshot ring, periodic stats and the exported designs.
+class RunOutputs {
+public:
+    explicit RunOutputs(const RunOptions &options);
+
+    // Returns false if a requested output could not be opened
+    bool open();
+
+    void afterTick(unsigned long tick, const std::list<Creature *> &creatureList, b2ParticleSystem *particleSystem,
+                   const FullInstrumentation &instrumentation);
+
+    // Finishes queued frames and the recording, then exports the designs of the survivors
+    void finish(const std::list<Creature *> &creatureList);
+
+private:
+    const RunOptions &options;
+    std::unique_ptr<FrameCapture> frameCapture;
+    std::unique_ptr<ReplayRecorder> replayRecorder;
+    std::unique_ptr<SnapshotRingWriter> snapshotRing;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_RUN_OPTIONS_H
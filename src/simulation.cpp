@@ -0,0 +1,207 @@
+#include "simulation.h"
+#include "lineage.h"
+#include <algorithm>
+
+namespace {
+    const float32 TIME_STEP = 1.0f / 60.0f;
+    const int32 VELOCITY_ITERATIONS = 6;
+    const int32 POSITION_ITERATIONS = 2;
+    const int32 PARTICLE_ITERATIONS = 1;
+}
+
+b2Body *createWorldBoundaries(b2World &world, float squareWidth) {
+
+    b2BodyDef squareBodyDef;
+    squareBodyDef.type = b2_staticBody;
+    squareBodyDef.position.Set(0, 0); // You can adjust the position if needed
+    b2Body *squareBody = world.CreateBody(&squareBodyDef);
+
+    b2EdgeShape topEdge, bottomEdge, leftEdge, rightEdge;
+
+    // Set the vertices of the edge shapes
+    topEdge.Set(b2Vec2(0, squareWidth), b2Vec2(squareWidth, squareWidth));
+    bottomEdge.Set(b2Vec2(0, 0), b2Vec2(squareWidth, 0));
+    leftEdge.Set(b2Vec2(0, 0), b2Vec2(0, squareWidth));
+    rightEdge.Set(b2Vec2(squareWidth, 0), b2Vec2(squareWidth, squareWidth));
+
+    b2FixtureDef squareFixtureDef;
+    squareFixtureDef.density = 0; // Static bodies don't need density
+    squareFixtureDef.restitution = 0.5f; // Adjust the restitution (bounciness) if needed
+    squareFixtureDef.friction = 0.5f; // Adjust the friction if needed
+
+    // Attach the edge shapes to the square body
+    squareFixtureDef.shape = &topEdge;
+    squareBody->CreateFixture(&squareFixtureDef);
+
+    squareFixtureDef.shape = &bottomEdge;
+    squareBody->CreateFixture(&squareFixtureDef);
+
+    squareFixtureDef.shape = &leftEdge;
+    squareBody->CreateFixture(&squareFixtureDef);
+
+    squareFixtureDef.shape = &rightEdge;
+    squareBody->CreateFixture(&squareFixtureDef);
+
+    return squareBody;
+}
+
+void clampCreaturePositions(const Creature *creature, float minX, float maxX, float minY, float maxY,
+                            BodyCommandQueue &commands) {
+    for (b2Body *bodyPart: creature->getBodyParts()) {
+        b2Vec2 position = bodyPart->GetPosition();
+
+        float clampedX = std::max(minX, std::min(position.x, maxX));
+        float clampedY = std::max(minY, std::min(position.y, maxY));
+
+        if (position.x != clampedX || position.y != clampedY) {
+            commands.setTransform(bodyPart, b2Vec2(clampedX, clampedY), bodyPart->GetAngle());
+        }
+    }
+}
+
+void refillParticles(b2ParticleSystem *particleSystem, int32 minParticleCount, const b2ParticleGroupDef &groupDef,
+                     const b2Vec2 &position) {
+    b2ParticleDef particleDef;
+    particleDef.flags = groupDef.flags;
+    particleDef.position = position;
+    particleDef.color = groupDef.color;
+    particleDef.lifetime = groupDef.lifetime;
+    particleDef.userData = groupDef.userData;
+
+    for (int32 i = particleSystem->GetParticleCount(); i < minParticleCount; ++i) {
+        particleSystem->CreateParticle(particleDef);
+    }
+}
+
+int32 feedCreatures(b2ParticleSystem *particleSystem, float amount) {
+    int32 bodyContactCount = particleSystem->GetBodyContactCount();
+    const b2ParticleBodyContact *bodyContacts = particleSystem->GetBodyContacts();
+    int32 feedingContacts = 0;
+
+    for (int32 i = 0; i < bodyContactCount; ++i) {
+        b2Body *contactedBody = bodyContacts[i].body;
+
+        // Only creature bodies are dynamic; the world boundaries are static
+        if (contactedBody->GetType() == b2_dynamicBody) {
+            auto *bodyData = static_cast<BodyData *>(contactedBody->GetUserData());
+            bodyData->parentCreature->addToHealth(amount);
+            ++feedingContacts;
+        }
+    }
+
+    return feedingContacts;
+}
+
+b2ParticleSystem *createParticleSystem(b2World &world) {
+    b2ParticleSystemDef particleSystemDef;
+    particleSystemDef.radius = 0.1f;
+    particleSystemDef.surfaceTensionNormalStrength = 1.0f;
+    particleSystemDef.surfaceTensionPressureStrength = 1.0f;
+    particleSystemDef.staticPressureStrength = 5.0f;
+    return world.CreateParticleSystem(&particleSystemDef);
+}
+
+void stepWorld(b2World &world) {
+    world.Step(TIME_STEP, VELOCITY_ITERATIONS, POSITION_ITERATIONS, PARTICLE_ITERATIONS);
+}
+
+void prepareWorldsForThreads() {
+    // Constructing the world fills b2BlockAllocator's size map. The contact function table
+    // (b2Contact::InitializeRegisters) is protected and only filled when the first contact is created, so
+    // make one: two overlapping boxes and a step.
+    b2World warmUp(b2Vec2(0.0f, 0.0f));
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+    for (int i = 0; i < 2; ++i) {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(0.25f * i, 0.0f);
+        warmUp.CreateBody(&bodyDef)->CreateFixture(&box, 1.0f);
+    }
+    stepWorld(warmUp);
+}
+
+uint32 deriveSeed(uint32 seed, uint32 stream) {
+    uint32 x = seed + 0x9e3779b9u * (stream + 1);
+    x = (x ^ (x >> 16)) * 0x85ebca6bu;
+    x = (x ^ (x >> 13)) * 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x != 0 ? x : 1;
+}
+
+bool setSimulationParam(SimulationParams &params, const std::string &name, double value) {
+    auto number = static_cast<float>(value);
+    if (name == "gravity-x") {
+        params.gravity.x = number;
+    } else if (name == "gravity-y") {
+        params.gravity.y = number;
+    } else if (name == "world-size") {
+        params.worldSize = number;
+    } else if (name == "min-particles") {
+        params.minParticleCount = static_cast<int32>(value);
+    } else if (name == "feed") {
+        params.feedAmount = number;
+    } else if (name == "metabolism") {
+        params.metabolism = number;
+    } else if (name == "force") {
+        params.forceMagnitude = number;
+    } else if (name == "reproduction-threshold") {
+        params.reproductionThreshold = number;
+    } else if (name == "reproduction-cost") {
+        params.reproductionCost = number;
+    } else if (name == "mutation-rate") {
+        params.mutationRate = number;
+    } else if (name == "max-population") {
+        params.maxPopulation = static_cast<size_t>(value);
+    } else if (name == "memory-budget-mb") {
+        params.memoryBudgetBytes = static_cast<size_t>(value * 1024.0 * 1024.0);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *simulationParamNames() {
+    return "gravity-x, gravity-y, world-size, min-particles, feed, metabolism, force, reproduction-threshold, "
+           "reproduction-cost, mutation-rate, max-population, memory-budget-mb";
+}
+
+const bool NoInstrumentation::TRACKS_HEALTH;
+const bool FullInstrumentation::TRACKS_HEALTH;
+
+FullInstrumentation::FullInstrumentation(const SimulationParams &params, LineageStore *lineage)
+        : populationIndex(params.evictionPolicy), lineage(lineage) {
+    populationBudget.maxPopulation = params.maxPopulation;
+    populationBudget.maxBytes = params.memoryBudgetBytes;
+}
+
+void FullInstrumentation::onBorn(Creature *creature, unsigned long tick) {
+    memoryAccounting.onCreatureBorn(creature);
+    populationIndex.add(creature);
+    if (lineage) {
+        lineage->recordBirth(creature, tick);
+    }
+}
+
+void FullInstrumentation::onDied(Creature *creature, unsigned long tick) {
+    memoryAccounting.onCreatureDied(creature);
+    populationIndex.remove(creature);
+    if (lineage) {
+        lineage->recordDeath(creature->getId(), tick);
+    }
+}
+
+void FullInstrumentation::afterMetabolism(const std::vector<Creature *> &creatures,
+                                          const std::vector<float> &previousHealth) {
+    populationIndex.onHealthChanged(creatures, previousHealth);
+}
+
+void FullInstrumentation::afterGrowth(b2World &world, b2ParticleSystem *particleSystem, size_t population) {
+    memoryAccounting.update(world, *particleSystem);
+
+    if (populationBudget.isLimited()) {
+        enforcePopulationBudget(populationBudget, populationIndex.getEvictionHeap(), population,
+                                memoryAccounting.getCounters().creatureTotalBytes());
+    }
+}
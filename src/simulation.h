@@ -0,0 +1,432 @@
+#ifndef LIQUIDFUN_EVO_SIM_SIMULATION_H
+#define LIQUIDFUN_EVO_SIM_SIMULATION_H
+
+#include <Box2D/Box2D.h>
+#include <Box2D/Particle/b2ParticleSystem.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+#include "body_commands.h"
+#include "creature.h"
+#include "eviction.h"
+#include "memory_accounting.h"
+#include "population_index.h"
+#include "thread_pool.h"
+
+// The per-tick rules of the world, shared by the interactive simulation and the fitness evaluator so both
+// score creatures the same way.
+
+// Static square of edges from (0, 0) to (squareWidth, squareWidth).
+b2Body *createWorldBoundaries(b2World &world, float squareWidth);
+
+// Moves any body part of the creature outside the box back onto its edge. The moves are staged in `commands`,
+// so this is safe on worker threads; commit the queue on the main thread to apply them.
+void clampCreaturePositions(const Creature *creature, float minX, float maxX, float minY, float maxY,
+                            BodyCommandQueue &commands);
+
+// Tops the particle system back up to minParticleCount, spawning the missing particles at `position`.
+void refillParticles(b2ParticleSystem *particleSystem, int32 minParticleCount, const b2ParticleGroupDef &groupDef,
+                     const b2Vec2 &position);
+
+// Gives every creature `amount` health per particle touching one of its bodies. Returns the number of
+// feeding contacts.
+int32 feedCreatures(b2ParticleSystem *particleSystem, float amount);
+
+// Pushes each body part of the creature in a random direction, staging the forces in `commands`; safe on
+// worker threads.
+template<class Rng>
+void applyRandomForces(const Creature *creature, float magnitude, Rng &rng, BodyCommandQueue &commands) {
+    std::uniform_real_distribution<float> angleDistribution(0.0f, 2.0f * b2_pi);
+
+    for (b2Body *movingBody: creature->getBodyParts()) {
+        float orientation = angleDistribution(rng);
+        commands.applyForceToCenter(movingBody, b2Vec2(magnitude * std::cos(orientation),
+                                                       magnitude * std::sin(orientation)));
+    }
+}
+
+// Particle system with the fluid settings every world uses.
+b2ParticleSystem *createParticleSystem(b2World &world);
+
+// One fixed 1/60 s step with the iteration counts every run uses.
+void stepWorld(b2World &world);
+
+// Box2D fills two global tables lazily: b2BlockAllocator's size map when the first allocator is constructed
+// and b2Contact's shape-pair function table when the first contact is created. This builds a throwaway world
+// that does both. Call it once on the main thread before stepping worlds on several threads at once.
+void prepareWorldsForThreads();
+
+// Every tunable of the world. Defaults are the values the simulation has always used.
+struct SimulationParams {
+    b2Vec2 gravity = b2Vec2(0.0f, -1.0f);
+    float worldSize = 100.0f;
+    int32 minParticleCount = 600;
+    float feedAmount = 0.01f;   // health per touching particle per tick
+    float metabolism = 0.02f;   // health lost per tick
+    float forceMagnitude = 1.0f;
+    float reproductionThreshold = 200.0f;
+    float reproductionCost = 100.0f;
+    float mutationRate = 0.1f;
+
+    // Population and memory limits (0 = unlimited) and which creatures go first when they are exceeded. The
+    // memory budget covers creatures only, since particles and contacts are not freed by evicting.
+    size_t maxPopulation = 0;
+    size_t memoryBudgetBytes = 0;
+    EvictionPolicy evictionPolicy = EvictionPolicy::LowestHealthFirst;
+
+    // Water block placed at the start, centred on particleBlockPosition
+    float particleBlockSize = 8.0f;
+    b2Vec2 particleBlockPosition = b2Vec2(10.0f, 4.0f);
+
+    // The two single-box creatures every run starts from. Runs that bring their own (the evaluator) turn them
+    // off and call Simulation::addCreature instead.
+    bool starterCreatures = true;
+
+    uint32 seed = 0; // 0 seeds from the clock
+};
+
+// Seed for the `stream`th of several runs sharing a base seed (sweep runs, evaluation repeats). A
+// splitmix32-style mix, so neighbouring streams are unrelated; never 0, which would mean "seed from the clock".
+uint32 deriveSeed(uint32 seed, uint32 stream);
+
+// Sets a parameter by its command line name, e.g. "feed" or "gravity-y". Returns false for unknown names.
+bool setSimulationParam(SimulationParams &params, const std::string &name, double value);
+
+// Comma separated list of the names setSimulationParam accepts.
+const char *simulationParamNames();
+
+class LineageStore;
+
+// Policies a Simulation<Config> is assembled from. Config provides the types Renderer, Food, Locomotion, Rng
+// and Instrumentation; picking the empty ones compiles the feature out of the tick entirely.
+
+// Draws nothing; for builds without a window.
+struct NullRenderer {
+    void draw(const std::list<Creature *> &, b2ParticleSystem *, float) {}
+};
+
+// Creatures gain health from the particles touching them.
+struct ParticleFood {
+    void feed(b2ParticleSystem *particleSystem, const SimulationParams &params) {
+        feedCreatures(particleSystem, params.feedAmount);
+    }
+};
+
+// ParticleFood that also totals the health it hands out; the evaluator's fitness.
+class CountingParticleFood {
+public:
+    void feed(b2ParticleSystem *particleSystem, const SimulationParams &params) {
+        energyGiven += static_cast<float>(feedCreatures(particleSystem, params.feedAmount)) * params.feedAmount;
+    }
+
+    float getEnergyGiven() const { return energyGiven; }
+
+private:
+    float energyGiven = 0.0f;
+};
+
+// Every body part is pushed in a random direction each tick. Runs on worker threads, so forces go through
+// the worker's command queue.
+struct RandomForceLocomotion {
+    template<class Rng>
+    void move(const Creature *creature, const SimulationParams &params, Rng &rng, BodyCommandQueue &commands) {
+        applyRandomForces(creature, params.forceMagnitude, rng, commands);
+    }
+};
+
+// xorshift64*: much smaller and faster to step than mt19937, and plenty for jiggling creatures around.
+class XorShiftRng {
+public:
+    typedef uint32_t result_type;
+
+    explicit XorShiftRng(uint64_t seed) : state(seed != 0 ? seed : 0x9e3779b97f4a7c15ull) {}
+
+    static constexpr result_type min() { return 0; }
+
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    result_type operator()() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return static_cast<result_type>((state * 0x2545f4914f6cdd1dull) >> 32);
+    }
+
+private:
+    uint64_t state;
+};
+
+// No bookkeeping at all: population limits, memory accounting and lineage are all off.
+struct NoInstrumentation {
+    // Whether afterMetabolism needs the health each creature had before it
+    static const bool TRACKS_HEALTH = false;
+
+    NoInstrumentation(const SimulationParams &, LineageStore *) {}
+
+    void onBorn(Creature *, unsigned long) {}
+
+    void onDied(Creature *, unsigned long) {}
+
+    void afterMetabolism(const std::vector<Creature *> &, const std::vector<float> &) {}
+
+    void afterGrowth(b2World &, b2ParticleSystem *, size_t) {}
+};
+
+// Memory accounting, the population index and budget and, when given a store, lineage recording.
+class FullInstrumentation {
+public:
+    static const bool TRACKS_HEALTH = true;
+
+    FullInstrumentation(const SimulationParams &params, LineageStore *lineage);
+
+    void onBorn(Creature *creature, unsigned long tick);
+
+    void onDied(Creature *creature, unsigned long tick);
+
+    // Every creature's health changed on worker threads; `previousHealth` holds what each had before
+    void afterMetabolism(const std::vector<Creature *> &creatures, const std::vector<float> &previousHealth);
+
+    // Refreshes the counters and marks creatures over the population budget for the death sweep
+    void afterGrowth(b2World &world, b2ParticleSystem *particleSystem, size_t population);
+
+    const MemoryAccounting &getMemoryAccounting() const { return memoryAccounting; }
+
+    const PopulationIndex &getPopulationIndex() const { return populationIndex; }
+
+private:
+    MemoryAccounting memoryAccounting;
+    PopulationIndex populationIndex;
+    PopulationBudget populationBudget;
+    LineageStore *lineage;
+};
+
+// Everything but drawing: parameter sweeps and other batch runs.
+struct HeadlessConfig {
+    typedef NullRenderer Renderer;
+    typedef ParticleFood Food;
+    typedef RandomForceLocomotion Locomotion;
+    typedef std::mt19937 Rng;
+    typedef FullInstrumentation Instrumentation;
+};
+
+// A world with its creatures and particles, advanced one tick at a time. What it draws with, how creatures
+// feed and move, its random numbers and its bookkeeping come from Config, so each build only pays for the
+// features it uses.
+template<class Config>
+class Simulation {
+public:
+    typedef typename Config::Instrumentation Instrumentation;
+
+    // Births and deaths are recorded in `lineage` when given (and the instrumentation records lineage); it
+    // must outlive the simulation. With a pool, the per-creature passes of each tick are split across its
+    // threads; the pool must outlive the simulation and not be running anything else while it steps.
+    explicit Simulation(const SimulationParams &params, LineageStore *lineage = nullptr,
+                        ThreadPool *pool = nullptr);
+
+    ~Simulation();
+
+    Simulation(const Simulation &) = delete;
+
+    Simulation &operator=(const Simulation &) = delete;
+
+    // Clamps, moves and metabolizes every creature (in parallel with a pool), feeds, steps the world, then
+    // applies reproduction, the population budget and the death sweep.
+    void step();
+
+    void render() { renderer.draw(creatureList, particleSystem, params.worldSize); }
+
+    // Takes ownership of a creature built in getWorld(); it counts as born this tick.
+    void addCreature(Creature *creature);
+
+    // Ticks completed so far
+    unsigned long getTick() const { return tick; }
+
+    const SimulationParams &getParams() const { return params; }
+
+    b2World &getWorld() { return world; }
+
+    b2ParticleSystem *getParticleSystem() const { return particleSystem; }
+
+    const std::list<Creature *> &getCreatures() const { return creatureList; }
+
+    const Instrumentation &getInstrumentation() const { return instrumentation; }
+
+    const typename Config::Food &getFood() const { return food; }
+
+private:
+    // Below this many creatures per range, waking another thread costs more than it saves
+    static const int MIN_CREATURES_PER_THREAD = 64;
+
+    // Clamping, locomotion and metabolism for creatures [begin, end). Touches only those creatures and the
+    // worker's own RNG and command queue, so ranges can run concurrently.
+    void updateCreatures(int begin, int end, int worker);
+
+    SimulationParams params;
+    b2World world;
+    b2ParticleSystem *particleSystem;
+    b2PolygonShape particleShape;
+    b2ParticleGroupDef particleGroupDef;
+    std::list<Creature *> creatureList;
+
+    Instrumentation instrumentation;
+    typename Config::Renderer renderer;
+    typename Config::Food food;
+    typename Config::Locomotion locomotion;
+    typename Config::Rng rng;
+
+    ThreadPool *pool;
+    std::vector<typename Config::Rng> workerRngs; // seeded from rng, one per pool thread
+    BodyCommandBuffer bodyCommands;
+    std::vector<Creature *> creatures; // creatureList as an array, for splitting into ranges
+    std::vector<float> previousHealth; // only filled when Instrumentation::TRACKS_HEALTH
+
+    unsigned long tick;
+};
+
+template<class Config>
+Simulation<Config>::Simulation(const SimulationParams &params, LineageStore *lineage, ThreadPool *pool)
+        : params(params), world(params.gravity), instrumentation(params, lineage),
+          rng(params.seed != 0 ? params.seed : static_cast<uint32>(
+                  std::chrono::steady_clock::now().time_since_epoch().count())),
+          pool(pool), bodyCommands(pool ? pool->size() : 1), tick(0) {
+    createWorldBoundaries(world, params.worldSize);
+
+    for (int worker = 0; worker < (pool ? pool->size() : 1); ++worker) {
+        workerRngs.emplace_back(rng());
+    }
+
+    if (params.starterCreatures) {
+        // Create a dynamic body
+        auto *creature1 = new Creature();
+        creature1->addBodyPart(Creature::createBodyPart(&world, creature1, 5.0f, 5.0f, 1.0f, 1.0f));
+
+        auto *creature2 = new Creature();
+        creature2->addBodyPart(Creature::createBodyPart(&world, creature2, 15.0f, 5.0f, 2.0f, 2.0f));
+
+        addCreature(creature1);
+        addCreature(creature2);
+    }
+
+    particleSystem = createParticleSystem(world);
+
+    // Create a particle group
+    particleShape.SetAsBox(params.particleBlockSize / 2.0f, params.particleBlockSize / 2.0f);
+    particleGroupDef.shape = &particleShape;
+    particleGroupDef.flags = b2_waterParticle;
+    particleGroupDef.position = params.particleBlockPosition;
+    particleSystem->CreateParticleGroup(particleGroupDef);
+}
+
+template<class Config>
+Simulation<Config>::~Simulation() {
+    for (Creature *creature: creatureList) {
+        Creature::destroy(&world, creature);
+    }
+    creatureList.clear();
+}
+
+template<class Config>
+void Simulation<Config>::addCreature(Creature *creature) {
+    creatureList.push_back(creature);
+    instrumentation.onBorn(creature, tick);
+}
+
+template<class Config>
+void Simulation<Config>::updateCreatures(int begin, int end, int worker) {
+    float minPosition = 0.5f;
+    float maxPosition = params.worldSize - 0.5f;
+    typename Config::Rng &workerRng = workerRngs[worker];
+    BodyCommandQueue &commands = bodyCommands.queue(worker);
+
+    for (int i = begin; i < end; ++i) {
+        Creature *creature = creatures[i];
+        clampCreaturePositions(creature, minPosition, maxPosition, minPosition, maxPosition, commands);
+
+        // Forces last until the next world step, so pushing here is the same as after the previous step
+        locomotion.move(creature, params, workerRng, commands);
+
+        if (Instrumentation::TRACKS_HEALTH) {
+            previousHealth[i] = creature->getHealth();
+        }
+        creature->addToHealthDeferred(-params.metabolism);
+    }
+}
+
+template<class Config>
+void Simulation<Config>::step() {
+    creatures.assign(creatureList.begin(), creatureList.end());
+    if (Instrumentation::TRACKS_HEALTH) {
+        previousHealth.resize(creatures.size());
+    }
+
+    // Only as many ranges as keep MIN_CREATURES_PER_THREAD in each. Range i uses command queue and RNG i, so
+    // the result does not depend on which thread happens to run it.
+    int count = static_cast<int>(creatures.size());
+    int ranges = pool ? std::min(pool->size(), count / MIN_CREATURES_PER_THREAD) : 1;
+    if (ranges >= 2) {
+        pool->parallelFor(ranges, [this, count, ranges](int beginRange, int endRange, int) {
+            for (int range = beginRange; range < endRange; ++range) {
+                updateCreatures(static_cast<int>(static_cast<long long>(count) * range / ranges),
+                                static_cast<int>(static_cast<long long>(count) * (range + 1) / ranges), range);
+            }
+        });
+    } else {
+        updateCreatures(0, count, 0);
+    }
+
+    // The population index is not thread-safe, so it hears about metabolism here
+    instrumentation.afterMetabolism(creatures, previousHealth);
+    bodyCommands.commit();
+
+    if (particleSystem->GetParticleCount() < params.minParticleCount) {
+        std::uniform_real_distribution<float> positionDistribution(0.0f, params.worldSize);
+        float x = positionDistribution(rng);
+        float y = positionDistribution(rng);
+        refillParticles(particleSystem, params.minParticleCount, particleGroupDef, b2Vec2(x, y));
+    }
+
+    food.feed(particleSystem, params);
+
+    stepWorld(world);
+
+    std::list<Creature *> newCreatureList;
+    std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+    UnitRandom random = [this, &unitDistribution]() { return unitDistribution(rng); };
+
+    // Reproduce successful creatures. Creates bodies, so stays on this thread.
+    for (Creature *creature: creatureList) {
+        if (creature->getHealth() > params.reproductionThreshold) {
+            creature->addToHealth(-params.reproductionCost);
+
+            Creature *newCreature = creature->reproduce(&world, random, params.mutationRate);
+            instrumentation.onBorn(newCreature, tick);
+            newCreatureList.push_back(newCreature);
+        }
+    }
+
+    creatureList.splice(creatureList.end(), newCreatureList);
+
+    // Evicted creatures are left at zero health for the sweep below
+    instrumentation.afterGrowth(world, particleSystem, creatureList.size());
+
+    // Remove dead creatures
+    for (auto it = creatureList.begin(); it != creatureList.end(); /* no increment here */) {
+        Creature *creature = *it;
+        if (creature->getHealth() < 1.0f) {
+            instrumentation.onDied(creature, tick);
+            Creature::destroy(&world, creature);
+            it = creatureList.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    ++tick;
+}
+
+#endif //LIQUIDFUN_EVO_SIM_SIMULATION_H
@@ -0,0 +1,186 @@
+#include "snapshot_ring.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace {
+    const char RING_MAGIC[8] = {'E', 'V', 'O', 'R', 'I', 'N', 'G', '1'};
+    const uint32_t RING_VERSION = 1;
+
+    // Keep the header and every slot on their own cache lines
+    const size_t ALIGNMENT = 64;
+
+    size_t alignUp(size_t value) {
+        return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    size_t slotSizeFor(uint32_t maxPolygons, uint32_t maxParticles) {
+        return alignUp(alignUp(sizeof(SnapshotSlotHeader)) + maxPolygons * sizeof(SnapshotPolygon) +
+                       maxParticles * sizeof(b2Vec2));
+    }
+
+    size_t ringSizeFor(uint32_t slotCount, uint32_t maxPolygons, uint32_t maxParticles) {
+        return alignUp(sizeof(SnapshotRingHeader)) + slotCount * slotSizeFor(maxPolygons, maxParticles);
+    }
+
+    uint8_t *slotAt(const SnapshotRingHeader *header, uint64_t sequence) {
+        uint64_t index = (sequence - 1) % header->slotCount;
+        return const_cast<uint8_t *>(reinterpret_cast<const uint8_t *>(header)) +
+               alignUp(sizeof(SnapshotRingHeader)) + index * header->slotSize;
+    }
+
+    SnapshotPolygon *slotPolygons(uint8_t *slot) {
+        return reinterpret_cast<SnapshotPolygon *>(slot + alignUp(sizeof(SnapshotSlotHeader)));
+    }
+
+    b2Vec2 *slotParticles(uint8_t *slot, uint32_t maxPolygons) {
+        return reinterpret_cast<b2Vec2 *>(slot + alignUp(sizeof(SnapshotSlotHeader)) +
+                                          maxPolygons * sizeof(SnapshotPolygon));
+    }
+}
+
+SnapshotRingWriter::SnapshotRingWriter(const std::string &name, uint32_t slotCount, uint32_t maxPolygons,
+                                       uint32_t maxParticles)
+        : header(nullptr), sequence(0) {
+    slotCount = std::max(2u, slotCount);
+    if (!region.createShared(name, ringSizeFor(slotCount, maxPolygons, maxParticles))) {
+        return;
+    }
+
+    header = static_cast<SnapshotRingHeader *>(region.getData());
+    memcpy(header->magic, RING_MAGIC, sizeof(RING_MAGIC));
+    header->version = RING_VERSION;
+    header->slotCount = slotCount;
+    header->maxPolygons = maxPolygons;
+    header->maxParticles = maxParticles;
+    header->slotSize = slotSizeFor(maxPolygons, maxParticles);
+    new(&header->latestSequence) std::atomic<uint64_t>(0);
+    new(&header->writerActive) std::atomic<uint32_t>(1);
+
+    for (uint64_t slot = 1; slot <= slotCount; ++slot) {
+        auto *slotHeader = reinterpret_cast<SnapshotSlotHeader *>(slotAt(header, slot));
+        new(&slotHeader->version) std::atomic<uint64_t>(0);
+    }
+}
+
+SnapshotRingWriter::~SnapshotRingWriter() {
+    if (header) {
+        header->writerActive.store(0, std::memory_order_release);
+    }
+}
+
+void SnapshotRingWriter::publish(unsigned long tick, const std::list<Creature *> &creatureList,
+                                 b2ParticleSystem *particleSystem, float worldSize) {
+    if (!header) {
+        return;
+    }
+
+    uint64_t next = sequence + 1;
+    uint8_t *slot = slotAt(header, next);
+    auto *slotHeader = reinterpret_cast<SnapshotSlotHeader *>(slot);
+
+    // Odd version: readers that see it (or see it change) discard what they read
+    uint64_t version = slotHeader->version.load(std::memory_order_relaxed);
+    slotHeader->version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SnapshotPolygon *polygons = slotPolygons(slot);
+    uint32_t polygonCount = 0;
+    bool truncated = false;
+    for (const Creature *creature: creatureList) {
+        for (b2Body *body: creature->getBodyParts()) {
+            for (b2Fixture *fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+                if (fixture->GetType() != b2Shape::e_polygon) {
+                    continue;
+                }
+                if (polygonCount == header->maxPolygons) {
+                    truncated = true;
+                    break;
+                }
+                makeSnapshotPolygon(creature, body, static_cast<b2PolygonShape *>(fixture->GetShape()),
+                                    polygons[polygonCount++]);
+            }
+        }
+    }
+
+    uint32_t particleCount = static_cast<uint32_t>(particleSystem->GetParticleCount());
+    if (particleCount > header->maxParticles) {
+        particleCount = header->maxParticles;
+        truncated = true;
+    }
+    memcpy(slotParticles(slot, header->maxPolygons), particleSystem->GetPositionBuffer(),
+           particleCount * sizeof(b2Vec2));
+
+    slotHeader->tick = tick;
+    slotHeader->worldSize = worldSize;
+    slotHeader->polygonCount = polygonCount;
+    slotHeader->particleCount = particleCount;
+    slotHeader->truncated = truncated ? 1 : 0;
+
+    slotHeader->version.store(version + 2, std::memory_order_release);
+    header->latestSequence.store(next, std::memory_order_release);
+    sequence = next;
+}
+
+bool SnapshotRingReader::open(const std::string &name) {
+    close();
+    if (!region.openShared(name)) {
+        return false;
+    }
+
+    auto *candidate = static_cast<const SnapshotRingHeader *>(region.getData());
+    if (region.getSize() < sizeof(SnapshotRingHeader) ||
+        memcmp(candidate->magic, RING_MAGIC, sizeof(RING_MAGIC)) != 0 || candidate->version != RING_VERSION ||
+        candidate->slotCount == 0 ||
+        region.getSize() < ringSizeFor(candidate->slotCount, candidate->maxPolygons, candidate->maxParticles)) {
+        std::cerr << "Shared memory " << name << " is not a compatible snapshot ring" << std::endl;
+        region.close();
+        return false;
+    }
+
+    header = candidate;
+    return true;
+}
+
+void SnapshotRingReader::close() {
+    region.close();
+    header = nullptr;
+}
+
+bool SnapshotRingReader::isWriterActive() const {
+    return header && header->writerActive.load(std::memory_order_acquire) != 0;
+}
+
+uint64_t SnapshotRingReader::getLatestSequence() const {
+    return header ? header->latestSequence.load(std::memory_order_acquire) : 0;
+}
+
+bool SnapshotRingReader::beginRead(SnapshotRingView &view) const {
+    uint64_t latest = getLatestSequence();
+    if (latest == 0) {
+        return false;
+    }
+
+    uint8_t *slot = slotAt(header, latest);
+    auto *slotHeader = reinterpret_cast<const SnapshotSlotHeader *>(slot);
+    uint64_t version = slotHeader->version.load(std::memory_order_acquire);
+    if (version & 1) {
+        return false;
+    }
+
+    view.slot = slotHeader;
+    view.version = version;
+    view.tick = static_cast<unsigned long>(slotHeader->tick);
+    view.worldSize = slotHeader->worldSize;
+    view.polygons = slotPolygons(slot);
+    view.polygonCount = std::min(slotHeader->polygonCount, header->maxPolygons);
+    view.particles = slotParticles(slot, header->maxPolygons);
+    view.particleCount = std::min(slotHeader->particleCount, header->maxParticles);
+    return true;
+}
+
+bool SnapshotRingReader::endRead(const SnapshotRingView &view) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return view.slot->version.load(std::memory_order_relaxed) == view.version;
+}
@@ -0,0 +1,104 @@
+#ifndef LIQUIDFUN_EVO_SIM_SNAPSHOT_RING_H
+#define LIQUIDFUN_EVO_SIM_SNAPSHOT_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include "memory_mapping.h"
+#include "world_snapshot.h"
+
+// Per-tick world snapshots published into a named shared memory ring so viewers in other processes can
+// attach and detach while the simulation keeps running. The writer never waits for readers: each slot is
+// guarded by a seqlock (odd version while being written), and readers check the version after using a slot
+// and simply retry if the writer lapped them.
+//
+// Layout: SnapshotRingHeader, then slotCount slots of
+//   SnapshotSlotHeader | SnapshotPolygon[maxPolygons] | b2Vec2[maxParticles]
+
+#define DEFAULT_SNAPSHOT_RING_NAME "liquidfun_evo_sim"
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory seqlock needs lock-free 64-bit atomics");
+
+struct SnapshotRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t maxPolygons;
+    uint32_t maxParticles;
+    uint64_t slotSize;
+    std::atomic<uint64_t> latestSequence; // 0 until the first publish; slot is (sequence - 1) % slotCount
+    std::atomic<uint32_t> writerActive;
+};
+
+struct SnapshotSlotHeader {
+    std::atomic<uint64_t> version;
+    uint64_t tick;
+    float worldSize;
+    uint32_t polygonCount;
+    uint32_t particleCount;
+    uint32_t truncated; // set when the world had more than the ring can hold
+};
+
+// Pointers straight into a mapped slot. Only valid while SnapshotRingReader::endRead says so.
+struct SnapshotRingView {
+    const SnapshotSlotHeader *slot;
+    uint64_t version;
+    unsigned long tick;
+    float worldSize;
+    const SnapshotPolygon *polygons;
+    size_t polygonCount;
+    const b2Vec2 *particles;
+    size_t particleCount;
+};
+
+class SnapshotRingWriter {
+public:
+    SnapshotRingWriter(const std::string &name, uint32_t slotCount = 8, uint32_t maxPolygons = 32768,
+                       uint32_t maxParticles = 65536);
+
+    // Marks the ring inactive so viewers know to detach, then removes it.
+    ~SnapshotRingWriter();
+
+    bool isOpen() const { return header != nullptr; }
+
+    // Writes the world directly into the next slot; no intermediate snapshot is built.
+    void publish(unsigned long tick, const std::list<Creature *> &creatureList, b2ParticleSystem *particleSystem,
+                 float worldSize);
+
+private:
+    MemoryMapping region;
+    SnapshotRingHeader *header;
+    uint64_t sequence;
+};
+
+class SnapshotRingReader {
+public:
+    SnapshotRingReader() : header(nullptr) {}
+
+    bool open(const std::string &name);
+
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+
+    // False once the simulation has shut down its end of the ring.
+    bool isWriterActive() const;
+
+    uint64_t getLatestSequence() const;
+
+    // Starts reading the most recently published slot. Returns false if nothing has been published yet or
+    // the slot is being rewritten right now.
+    bool beginRead(SnapshotRingView &view) const;
+
+    // True if the slot was not touched by the writer since beginRead, i.e. everything read through the
+    // view is consistent.
+    bool endRead(const SnapshotRingView &view) const;
+
+private:
+    MemoryMapping region;
+    const SnapshotRingHeader *header;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_SNAPSHOT_RING_H
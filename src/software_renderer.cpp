@@ -0,0 +1,241 @@
+#include "software_renderer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const uint8_t BOUNDARY_GRAY = 96;
+    const uint8_t PARTICLE_BLUE = 255;
+
+    inline uint8_t toByte(float value) {
+        return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+    }
+
+    inline float edgeFunction(float ax, float ay, float bx, float by, float px, float py) {
+        return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+    }
+
+    // Clamps to [low, high] before converting, so far off-screen coordinates stay defined as ints
+    inline int floorClamped(float value, int low, int high) {
+        return static_cast<int>(std::floor(std::min(std::max(value, static_cast<float>(low)),
+                                                     static_cast<float>(high))));
+    }
+
+    inline int ceilClamped(float value, int low, int high) {
+        return static_cast<int>(std::ceil(std::min(std::max(value, static_cast<float>(low)),
+                                                   static_cast<float>(high))));
+    }
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, ThreadPool &pool)
+        : width(width), height(height),
+          tilesX((width + TILE_SIZE - 1) / TILE_SIZE), tilesY((height + TILE_SIZE - 1) / TILE_SIZE),
+          pixelsPerUnit(1.0f), particleRadius(1.5f), worldSize(0.0f), pool(pool),
+          pixels(static_cast<size_t>(width) * height * 3, 0) {
+    triangleBins.assign(pool.size(), std::vector<std::vector<int>>(tilesX * tilesY));
+    discBins.assign(pool.size(), std::vector<std::vector<int>>(tilesX * tilesY));
+}
+
+void SoftwareRenderer::render(const WorldSnapshot &snapshot) {
+    bin(snapshot);
+
+    pool.parallelFor(tilesX * tilesY, [this](int begin, int end, int) {
+        for (int tile = begin; tile < end; ++tile) {
+            drawTile(tile);
+        }
+    });
+}
+
+void SoftwareRenderer::bin(const WorldSnapshot &snapshot) {
+    // Leave a one pixel border so the world boundary lines are visible
+    worldSize = snapshot.worldSize;
+    pixelsPerUnit = static_cast<float>(std::min(width, height) - 2) / std::max(worldSize, 1.0f);
+    particleRadius = std::max(1.5f, 0.1f * pixelsPerUnit);
+
+    const float pixelsPerUnitCopy = pixelsPerUnit;
+    const float imageHeight = static_cast<float>(height);
+    auto toScreen = [pixelsPerUnitCopy, imageHeight](const b2Vec2 &point, float &x, float &y) {
+        x = 1.0f + point.x * pixelsPerUnitCopy;
+        y = imageHeight - 1.0f - point.y * pixelsPerUnitCopy;
+    };
+
+    // Fan-triangulate the polygons in screen space
+    triangles.clear();
+    for (const SnapshotPolygon &polygon: snapshot.polygons) {
+        if (polygon.vertexCount < 3) {
+            continue;
+        }
+
+        b2Transform transform(polygon.position, b2Rot(polygon.angle));
+        float screenX[b2_maxPolygonVertices];
+        float screenY[b2_maxPolygonVertices];
+        bool finite = true;
+        for (int i = 0; i < polygon.vertexCount; ++i) {
+            toScreen(b2Mul(transform, polygon.vertices[i]), screenX[i], screenY[i]);
+            finite = finite && std::isfinite(screenX[i]) && std::isfinite(screenY[i]);
+        }
+        // A diverging body; nothing sensible to draw
+        if (!finite) {
+            continue;
+        }
+
+        // Same health tint as drawCreature
+        uint8_t r = toByte(polygon.r);
+        uint8_t g = toByte(polygon.g * polygon.health / 200.0f);
+        uint8_t b = toByte(polygon.b);
+
+        for (int i = 1; i + 1 < polygon.vertexCount; ++i) {
+            Triangle triangle = {screenX[0], screenY[0], screenX[i], screenY[i], screenX[i + 1], screenY[i + 1],
+                                 r, g, b};
+            triangles.push_back(triangle);
+        }
+    }
+
+    discs.clear();
+    for (const b2Vec2 &particle: snapshot.particles) {
+        Disc disc;
+        toScreen(particle, disc.x, disc.y);
+        if (std::isfinite(disc.x) && std::isfinite(disc.y)) {
+            discs.push_back(disc);
+        }
+    }
+
+    for (int worker = 0; worker < pool.size(); ++worker) {
+        for (int tile = 0; tile < tilesX * tilesY; ++tile) {
+            triangleBins[worker][tile].clear();
+            discBins[worker][tile].clear();
+        }
+    }
+
+    auto binBox = [this](std::vector<std::vector<int>> &bins, int index,
+                         float minX, float minY, float maxX, float maxY) {
+        if (maxX < 0 || maxY < 0 || minX >= width || minY >= height) {
+            return;
+        }
+        int firstTileX = floorClamped(minX, 0, width - 1) / TILE_SIZE;
+        int firstTileY = floorClamped(minY, 0, height - 1) / TILE_SIZE;
+        int lastTileX = floorClamped(maxX, 0, width - 1) / TILE_SIZE;
+        int lastTileY = floorClamped(maxY, 0, height - 1) / TILE_SIZE;
+        for (int tileY = firstTileY; tileY <= lastTileY; ++tileY) {
+            for (int tileX = firstTileX; tileX <= lastTileX; ++tileX) {
+                bins[tileY * tilesX + tileX].push_back(index);
+            }
+        }
+    };
+
+    pool.parallelFor(static_cast<int>(triangles.size()), [&](int begin, int end, int worker) {
+        for (int i = begin; i < end; ++i) {
+            const Triangle &t = triangles[i];
+            binBox(triangleBins[worker], i,
+                   std::min(t.x0, std::min(t.x1, t.x2)), std::min(t.y0, std::min(t.y1, t.y2)),
+                   std::max(t.x0, std::max(t.x1, t.x2)), std::max(t.y0, std::max(t.y1, t.y2)));
+        }
+    });
+
+    pool.parallelFor(static_cast<int>(discs.size()), [&](int begin, int end, int worker) {
+        for (int i = begin; i < end; ++i) {
+            const Disc &d = discs[i];
+            binBox(discBins[worker], i, d.x - particleRadius, d.y - particleRadius,
+                   d.x + particleRadius, d.y + particleRadius);
+        }
+    });
+}
+
+void SoftwareRenderer::drawTile(int tile) {
+    int minX = (tile % tilesX) * TILE_SIZE;
+    int minY = (tile / tilesX) * TILE_SIZE;
+    int maxX = std::min(minX + TILE_SIZE, width) - 1;
+    int maxY = std::min(minY + TILE_SIZE, height) - 1;
+
+    for (int y = minY; y <= maxY; ++y) {
+        std::fill(pixels.begin() + (static_cast<size_t>(y) * width + minX) * 3,
+                  pixels.begin() + (static_cast<size_t>(y) * width + maxX + 1) * 3, 0);
+    }
+
+    // World boundaries
+    int left = 0;
+    int right = std::min(width - 1, static_cast<int>(std::lround(1.0f + worldSize * pixelsPerUnit)));
+    int top = std::max(0, static_cast<int>(std::lround(height - 1.0f - worldSize * pixelsPerUnit)));
+    int bottom = height - 1;
+    for (int y = std::max(minY, top); y <= std::min(maxY, bottom); ++y) {
+        for (int x = std::max(minX, left); x <= std::min(maxX, right); ++x) {
+            if (x == left || x == right || y == top || y == bottom) {
+                uint8_t *pixel = &pixels[(static_cast<size_t>(y) * width + x) * 3];
+                pixel[0] = pixel[1] = pixel[2] = BOUNDARY_GRAY;
+            }
+        }
+    }
+
+    for (const std::vector<std::vector<int>> &workerBins: triangleBins) {
+        for (int index: workerBins[tile]) {
+            fillTriangle(triangles[index], minX, minY, maxX, maxY);
+        }
+    }
+
+    const float radiusSquared = particleRadius * particleRadius;
+    for (const std::vector<std::vector<int>> &workerBins: discBins) {
+        for (int index: workerBins[tile]) {
+            const Disc &disc = discs[index];
+            int x0 = std::max(minX, static_cast<int>(std::floor(disc.x - particleRadius)));
+            int x1 = std::min(maxX, static_cast<int>(std::ceil(disc.x + particleRadius)));
+            int y0 = std::max(minY, static_cast<int>(std::floor(disc.y - particleRadius)));
+            int y1 = std::min(maxY, static_cast<int>(std::ceil(disc.y + particleRadius)));
+            for (int y = y0; y <= y1; ++y) {
+                float dy = static_cast<float>(y) + 0.5f - disc.y;
+                for (int x = x0; x <= x1; ++x) {
+                    float dx = static_cast<float>(x) + 0.5f - disc.x;
+                    if (dx * dx + dy * dy <= radiusSquared) {
+                        uint8_t *pixel = &pixels[(static_cast<size_t>(y) * width + x) * 3];
+                        pixel[0] = 0;
+                        pixel[1] = 0;
+                        pixel[2] = PARTICLE_BLUE;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRenderer::fillTriangle(const Triangle &triangle, int minX, int minY, int maxX, int maxY) {
+    float x0 = triangle.x0, y0 = triangle.y0;
+    float x1 = triangle.x1, y1 = triangle.y1;
+    float x2 = triangle.x2, y2 = triangle.y2;
+
+    // Make the winding consistent so "inside" is always all edge functions >= 0
+    float area = edgeFunction(x0, y0, x1, y1, x2, y2);
+    if (std::fabs(area) < 1e-6f) {
+        return;
+    }
+    if (area < 0) {
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+    }
+
+    int startX = floorClamped(std::min(x0, std::min(x1, x2)), minX, maxX);
+    int endX = ceilClamped(std::max(x0, std::max(x1, x2)), minX, maxX);
+    int startY = floorClamped(std::min(y0, std::min(y1, y2)), minY, maxY);
+    int endY = ceilClamped(std::max(y0, std::max(y1, y2)), minY, maxY);
+
+    // Edge functions are linear, so step them by their x derivative along each row
+    float stepX0 = -(y2 - y1), stepX1 = -(y0 - y2), stepX2 = -(y1 - y0);
+
+    for (int y = startY; y <= endY; ++y) {
+        float py = static_cast<float>(y) + 0.5f;
+        float px = static_cast<float>(startX) + 0.5f;
+        float w0 = edgeFunction(x1, y1, x2, y2, px, py);
+        float w1 = edgeFunction(x2, y2, x0, y0, px, py);
+        float w2 = edgeFunction(x0, y0, x1, y1, px, py);
+
+        uint8_t *pixel = &pixels[(static_cast<size_t>(y) * width + startX) * 3];
+        for (int x = startX; x <= endX; ++x) {
+            if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
+                pixel[0] = triangle.r;
+                pixel[1] = triangle.g;
+                pixel[2] = triangle.b;
+            }
+            w0 += stepX0;
+            w1 += stepX1;
+            w2 += stepX2;
+            pixel += 3;
+        }
+    }
+}
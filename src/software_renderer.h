@@ -0,0 +1,62 @@
+#ifndef LIQUIDFUN_EVO_SIM_SOFTWARE_RENDERER_H
+#define LIQUIDFUN_EVO_SIM_SOFTWARE_RENDERER_H
+
+#include <cstdint>
+#include <vector>
+#include "thread_pool.h"
+#include "world_snapshot.h"
+
+// CPU rasterizer for WorldSnapshots, for machines without a GPU or display. The image is split into
+// square tiles; primitives are binned per tile and each tile is then filled independently on the pool.
+// The whole world is framed in the image, y pointing up like the OpenGL view.
+class SoftwareRenderer {
+public:
+    SoftwareRenderer(int width, int height, ThreadPool &pool);
+
+    void render(const WorldSnapshot &snapshot);
+
+    int getWidth() const { return width; }
+
+    int getHeight() const { return height; }
+
+    // Packed 8-bit RGB, top row first
+    const std::vector<uint8_t> &getPixels() const { return pixels; }
+
+private:
+    struct Triangle {
+        float x0, y0, x1, y1, x2, y2;
+        uint8_t r, g, b;
+    };
+
+    struct Disc {
+        float x, y;
+    };
+
+    void bin(const WorldSnapshot &snapshot);
+
+    void drawTile(int tile);
+
+    void fillTriangle(const Triangle &triangle, int minX, int minY, int maxX, int maxY);
+
+    static const int TILE_SIZE = 32;
+
+    int width;
+    int height;
+    int tilesX;
+    int tilesY;
+    float pixelsPerUnit;
+    float particleRadius;
+    float worldSize;
+    ThreadPool &pool;
+
+    std::vector<uint8_t> pixels;
+    std::vector<Triangle> triangles;
+    std::vector<Disc> discs;
+
+    // Per worker, per tile lists of primitive indices. Workers bin contiguous ranges, so walking the
+    // workers in order keeps the original draw order inside each tile.
+    std::vector<std::vector<std::vector<int>>> triangleBins;
+    std::vector<std::vector<std::vector<int>>> discBins;
+};
+
+#endif //LIQUIDFUN_EVO_SIM_SOFTWARE_RENDERER_H
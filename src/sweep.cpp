@@ -0,0 +1,233 @@
+#include "sweep.h"
+#include "parse_error.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace {
+    double parameterValue(const SweepParameter &parameter, int step) {
+        if (!parameter.values.empty()) {
+            return parameter.values[step];
+        }
+        if (parameter.steps <= 1) {
+            return parameter.low;
+        }
+        return parameter.low + (parameter.high - parameter.low) * step / (parameter.steps - 1);
+    }
+
+    int parameterSteps(const SweepParameter &parameter) {
+        return parameter.values.empty() ? parameter.steps : static_cast<int>(parameter.values.size());
+    }
+}
+
+const char *runOutcomeName(RunOutcome outcome) {
+    switch (outcome) {
+        case RunOutcome::Completed:
+            return "completed";
+        case RunOutcome::Extinct:
+            return "extinct";
+        case RunOutcome::Exploded:
+            return "exploded";
+    }
+    return "unknown";
+}
+
+bool readSweepSpec(const std::string &path, SweepSpec &spec) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open sweep spec: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream in(line);
+        std::string directive;
+        if (!(in >> directive)) {
+            continue;
+        }
+
+        if (directive == "mode") {
+            std::string mode;
+            in >> mode;
+            if (mode == "grid") {
+                spec.randomSampling = false;
+            } else if (mode == "random" && (in >> spec.samples) && spec.samples > 0) {
+                spec.randomSampling = true;
+            } else {
+                return parseError(path, lineNumber, "expected: mode grid | random N");
+            }
+        } else if (directive == "ticks") {
+            if (!(in >> spec.ticks)) {
+                return parseError(path, lineNumber, "expected: ticks N");
+            }
+        } else if (directive == "repeats") {
+            if (!(in >> spec.repeats) || spec.repeats < 1) {
+                return parseError(path, lineNumber, "expected: repeats N");
+            }
+        } else if (directive == "seed") {
+            if (!(in >> spec.seed)) {
+                return parseError(path, lineNumber, "expected: seed N");
+            }
+        } else if (directive == "explode-population") {
+            if (!(in >> spec.explosionPopulation)) {
+                return parseError(path, lineNumber, "expected: explode-population N");
+            }
+        } else if (directive == "explode-memory-mb") {
+            double megabytes;
+            if (!(in >> megabytes)) {
+                return parseError(path, lineNumber, "expected: explode-memory-mb M");
+            }
+            spec.explosionBytes = static_cast<size_t>(megabytes * 1024.0 * 1024.0);
+        } else if (directive == "set" || directive == "param") {
+            SweepParameter parameter;
+            if (!(in >> parameter.name)) {
+                return parseError(path, lineNumber, "expected a parameter name");
+            }
+
+            // Also checks that the name is known before any run starts
+            SimulationParams scratch;
+            if (!setSimulationParam(scratch, parameter.name, 0.0)) {
+                return parseError(path, lineNumber, "unknown parameter '" + parameter.name + "' (known: " +
+                                                    simulationParamNames() + ")");
+            }
+
+            if (directive == "set") {
+                double value;
+                if (!(in >> value)) {
+                    return parseError(path, lineNumber, "expected: set NAME VALUE");
+                }
+                setSimulationParam(spec.base, parameter.name, value);
+                continue;
+            }
+
+            std::string first;
+            if (!(in >> first)) {
+                return parseError(path, lineNumber, "expected values after the parameter name");
+            }
+            if (first == "range") {
+                if (!(in >> parameter.low >> parameter.high >> parameter.steps) || parameter.steps < 1) {
+                    return parseError(path, lineNumber, "expected: param NAME range LO HI N");
+                }
+            } else {
+                std::istringstream firstValue(first);
+                double value;
+                if (!(firstValue >> value)) {
+                    return parseError(path, lineNumber, "expected a number, got '" + first + "'");
+                }
+                parameter.values.push_back(value);
+                while (in >> value) {
+                    parameter.values.push_back(value);
+                }
+                if (!in.eof()) {
+                    return parseError(path, lineNumber, "expected a number");
+                }
+            }
+            spec.parameters.push_back(parameter);
+        } else {
+            return parseError(path, lineNumber, "unknown directive '" + directive + "'");
+        }
+    }
+
+    return true;
+}
+
+void expandSweep(const SweepSpec &spec, std::vector<SweepRun> &runs) {
+    std::vector<std::vector<double>> points;
+
+    if (spec.randomSampling) {
+        std::mt19937 rng(spec.seed);
+        for (size_t sample = 0; sample < spec.samples; ++sample) {
+            std::vector<double> point;
+            for (const SweepParameter &parameter: spec.parameters) {
+                if (!parameter.values.empty()) {
+                    std::uniform_int_distribution<size_t> pick(0, parameter.values.size() - 1);
+                    point.push_back(parameter.values[pick(rng)]);
+                } else {
+                    std::uniform_real_distribution<double> uniform(parameter.low, parameter.high);
+                    point.push_back(uniform(rng));
+                }
+            }
+            points.push_back(point);
+        }
+    } else {
+        // Odometer over every parameter's steps, last parameter varying fastest
+        std::vector<int> steps(spec.parameters.size(), 0);
+        while (true) {
+            std::vector<double> point;
+            for (size_t i = 0; i < spec.parameters.size(); ++i) {
+                point.push_back(parameterValue(spec.parameters[i], steps[i]));
+            }
+            points.push_back(point);
+
+            size_t digit = spec.parameters.size();
+            while (digit > 0 && ++steps[digit - 1] == parameterSteps(spec.parameters[digit - 1])) {
+                steps[digit - 1] = 0;
+                --digit;
+            }
+            if (digit == 0) {
+                break;
+            }
+        }
+    }
+
+    runs.clear();
+    for (const std::vector<double> &point: points) {
+        for (int repeat = 0; repeat < spec.repeats; ++repeat) {
+            SweepRun run;
+            run.index = runs.size();
+            run.values = point;
+            run.params = spec.base;
+            for (size_t i = 0; i < spec.parameters.size(); ++i) {
+                setSimulationParam(run.params, spec.parameters[i].name, point[i]);
+            }
+            run.params.seed = deriveSeed(spec.seed, static_cast<uint32>(run.index));
+            runs.push_back(run);
+        }
+    }
+}
+
+RunSummary runSweepRun(const SweepRun &run, const SweepSpec &spec) {
+    RunSummary summary;
+    Simulation<HeadlessConfig> simulation(run.params);
+    const MemoryAccounting &memoryAccounting = simulation.getInstrumentation().getMemoryAccounting();
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (simulation.getTick() < spec.ticks) {
+        simulation.step();
+
+        size_t population = simulation.getCreatures().size();
+        summary.peakPopulation = std::max(summary.peakPopulation, population);
+
+        if (population == 0) {
+            summary.outcome = RunOutcome::Extinct;
+            break;
+        }
+        if ((spec.explosionPopulation != 0 && population > spec.explosionPopulation) ||
+            (spec.explosionBytes != 0 &&
+             memoryAccounting.getCounters().totalBytes() > spec.explosionBytes)) {
+            summary.outcome = RunOutcome::Exploded;
+            break;
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    summary.ticks = simulation.getTick();
+    summary.finalPopulation = simulation.getCreatures().size();
+    summary.ticksPerSecond = elapsed.count() > 0.0 ? summary.ticks / elapsed.count() : 0.0;
+    summary.peakBytes = memoryAccounting.getCounters().peakBytes;
+    return summary;
+}
@@ -0,0 +1,73 @@
+#ifndef LIQUIDFUN_EVO_SIM_SWEEP_H
+#define LIQUIDFUN_EVO_SIM_SWEEP_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "simulation.h"
+
+// A parameter sweep over SimulationParams, read from a text spec ('#' starts a comment):
+//   mode grid | random N      grid runs every combination; random draws N points
+//   ticks N                   length of each run
+//   repeats N                 runs per point, each with its own seed
+//   seed N                    base seed for run seeds and random sampling
+//   explode-population N      stop a run early once it has more creatures than this (0 = never)
+//   explode-memory-mb M       ... or uses more memory than this (0 = never)
+//   set NAME VALUE            fixed value for every run
+//   param NAME V1 V2 ...      swept over the listed values
+//   param NAME range LO HI N  swept over N evenly spaced values in [LO, HI]; random mode samples uniformly
+// NAME is any name setSimulationParam accepts.
+
+struct SweepParameter {
+    std::string name;
+    std::vector<double> values; // empty for ranges
+    double low = 0.0;
+    double high = 0.0;
+    int steps = 1;
+};
+
+struct SweepSpec {
+    bool randomSampling = false;
+    size_t samples = 0;
+    unsigned long ticks = 10000;
+    int repeats = 1;
+    uint32 seed = 1;
+    size_t explosionPopulation = 20000;
+    size_t explosionBytes = 0;
+    SimulationParams base;
+    std::vector<SweepParameter> parameters;
+};
+
+// One simulation to run: the swept values (in SweepSpec::parameters order) applied on top of the base.
+struct SweepRun {
+    size_t index = 0;
+    std::vector<double> values;
+    SimulationParams params;
+};
+
+enum class RunOutcome {
+    Completed,
+    Extinct,
+    Exploded
+};
+
+const char *runOutcomeName(RunOutcome outcome);
+
+struct RunSummary {
+    RunOutcome outcome = RunOutcome::Completed;
+    unsigned long ticks = 0;
+    size_t finalPopulation = 0;
+    size_t peakPopulation = 0;
+    double ticksPerSecond = 0.0;
+    size_t peakBytes = 0;
+};
+
+bool readSweepSpec(const std::string &path, SweepSpec &spec);
+
+// Expands the spec into its individual runs, each with its own seed.
+void expandSweep(const SweepSpec &spec, std::vector<SweepRun> &runs);
+
+// Runs one headless simulation until spec.ticks, extinction or explosion.
+RunSummary runSweepRun(const SweepRun &run, const SweepSpec &spec);
+
+#endif //LIQUIDFUN_EVO_SIM_SWEEP_H
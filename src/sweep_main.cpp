@@ -0,0 +1,92 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "sweep.h"
+#include "thread_pool.h"
+
+// Runs every simulation of a sweep spec (see sweep.h) headless, as many at a time as there are cores, and
+// streams one CSV row per run as each finishes.
+int main(int argc, char **argv) {
+    std::string specPath;
+    std::string outputPath; // stdout when empty
+    int threads = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--out") == 0 && hasValue) {
+            outputPath = argv[++i];
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (specPath.empty() && arg[0] != '-') {
+            specPath = arg;
+        } else {
+            specPath.clear();
+            break;
+        }
+    }
+
+    if (specPath.empty()) {
+        std::cerr << "Usage: " << argv[0] << " SPEC [--out FILE] [--threads N]" << std::endl;
+        return 1;
+    }
+
+    SweepSpec spec;
+    if (!readSweepSpec(specPath, spec)) {
+        return 1;
+    }
+
+    std::vector<SweepRun> runs;
+    expandSweep(spec, runs);
+
+    std::ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath);
+        if (!file) {
+            std::cerr << "Failed to open output file: " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = outputPath.empty() ? std::cout : file;
+
+    out << "run,seed";
+    for (const SweepParameter &parameter: spec.parameters) {
+        out << "," << parameter.name;
+    }
+    out << ",outcome,ticks,final_population,peak_population,ticks_per_second,peak_memory_bytes" << std::endl;
+
+    // Each run is single-threaded, so one pool thread per core runs one simulation per core
+    ThreadPool pool(threads);
+    prepareWorldsForThreads();
+
+    std::cerr << "Running " << runs.size() << " simulations of up to " << spec.ticks << " ticks on "
+              << pool.size() << " threads" << std::endl;
+
+    std::mutex outputMutex;
+    size_t finished = 0;
+
+    pool.parallelForEach(static_cast<int>(runs.size()), [&](int index, int) {
+        const SweepRun &run = runs[index];
+        RunSummary summary = runSweepRun(run, spec);
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        out << run.index << "," << run.params.seed;
+        for (double value: run.values) {
+            out << "," << value;
+        }
+        out << "," << runOutcomeName(summary.outcome) << "," << summary.ticks << "," << summary.finalPopulation
+            << "," << summary.peakPopulation << "," << summary.ticksPerSecond << "," << summary.peakBytes
+            << std::endl;
+
+        ++finished;
+        std::cerr << "[" << finished << "/" << runs.size() << "] run " << run.index << " "
+                  << runOutcomeName(summary.outcome) << " after " << summary.ticks << " ticks" << std::endl;
+    });
+
+    return out ? 0 : 1;
+}
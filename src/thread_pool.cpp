@@ -0,0 +1,168 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <memory>
+
+namespace {
+    // Indices [next, end) still waiting to run on one thread. The owner takes from the front, thieves
+    // split off the back.
+    struct StealableRange {
+        std::mutex mutex;
+        int next = 0;
+        int end = 0;
+    };
+
+    // Moves the back half of some other thread's remaining range into `own` and returns the first stolen
+    // index, or -1 once there is nothing left to steal.
+    int steal(StealableRange *ranges, int threads, int self) {
+        for (int offset = 1; offset < threads; ++offset) {
+            StealableRange &victim = ranges[(self + offset) % threads];
+            int begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                int remaining = victim.end - victim.next;
+                if (remaining <= 0) {
+                    continue;
+                }
+                end = victim.end;
+                begin = end - (remaining + 1) / 2;
+                victim.end = begin;
+            }
+
+            StealableRange &own = ranges[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.next = begin + 1;
+            own.end = end;
+            return begin;
+        }
+        return -1;
+    }
+}
+
+ThreadPool::ThreadPool(int threadCount)
+        : currentFunction(nullptr), currentCount(0), generation(0), pendingWorkers(0), stopping(false) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    threadCount = std::max(1, threadCount);
+
+    // The caller always runs chunk 0, so only spawn the extra threads
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const RangeFunction &function) {
+    if (count <= 0) {
+        return;
+    }
+
+    // Not worth waking anyone up for a single thread's worth of work, and no waiting for another caller's job
+    std::unique_lock<std::mutex> dispatch(dispatchMutex, std::try_to_lock);
+    if (workers.empty() || count == 1 || !dispatch.owns_lock()) {
+        function(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentFunction = &function;
+        currentCount = count;
+        pendingWorkers = static_cast<int>(workers.size());
+        ++generation;
+    }
+    workReady.notify_all();
+
+    runChunk(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return pendingWorkers == 0; });
+    currentFunction = nullptr;
+}
+
+void ThreadPool::parallelForEach(int count, const IndexFunction &function) {
+    if (count <= 0) {
+        return;
+    }
+
+    int threads = std::min(size(), count);
+    std::unique_ptr<StealableRange[]> ranges(new StealableRange[threads]);
+    for (int i = 0; i < threads; ++i) {
+        ranges[i].next = static_cast<int>(static_cast<long long>(count) * i / threads);
+        ranges[i].end = static_cast<int>(static_cast<long long>(count) * (i + 1) / threads);
+    }
+
+    // One chunk per participating thread; the chunk index doubles as that thread's range
+    parallelFor(threads, [&](int begin, int end, int) {
+        for (int self = begin; self < end; ++self) {
+            while (true) {
+                int index = -1;
+                {
+                    std::lock_guard<std::mutex> lock(ranges[self].mutex);
+                    if (ranges[self].next < ranges[self].end) {
+                        index = ranges[self].next++;
+                    }
+                }
+                if (index < 0) {
+                    index = steal(ranges.get(), threads, self);
+                    if (index < 0) {
+                        break;
+                    }
+                }
+                function(index, self);
+            }
+        }
+    });
+}
+
+void ThreadPool::workerLoop(int worker) {
+    unsigned long seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [this, seenGeneration] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runChunk(worker);
+
+        bool lastToFinish;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lastToFinish = --pendingWorkers == 0;
+        }
+        if (lastToFinish) {
+            workDone.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runChunk(int worker) {
+    int threads = size();
+    int begin = static_cast<int>(static_cast<long long>(currentCount) * worker / threads);
+    int end = static_cast<int>(static_cast<long long>(currentCount) * (worker + 1) / threads);
+
+    if (begin < end) {
+        (*currentFunction)(begin, end, worker);
+    }
+}
+
+ThreadPool &sharedThreadPool(int threadCount) {
+    static ThreadPool pool(threadCount);
+    return pool;
+}
@@ -0,0 +1,64 @@
+#ifndef LIQUIDFUN_EVO_SIM_THREAD_POOL_H
+#define LIQUIDFUN_EVO_SIM_THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent set of worker threads for data-parallel passes. Workers sleep between jobs so a pool can be
+// created once and reused every frame without paying thread start-up costs.
+class ThreadPool {
+public:
+    // Called with a half-open range [begin, end) and the index of the worker running it.
+    typedef std::function<void(int begin, int end, int worker)> RangeFunction;
+
+    // Called once per index with the index of the worker running it.
+    typedef std::function<void(int index, int worker)> IndexFunction;
+
+    // threadCount of 0 picks one thread per hardware core. The calling thread counts as one of them.
+    explicit ThreadPool(int threadCount = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Number of threads that take part in a parallelFor, including the caller.
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Splits [0, count) into one contiguous chunk per thread and blocks until every chunk has run. If another
+    // thread already has a job running on the pool, the whole range runs on the calling thread instead of
+    // waiting, so subsystems sharing a pool never stall each other.
+    void parallelFor(int count, const RangeFunction &function);
+
+    // Runs function for every index in [0, count) and blocks until all are done. For items of uneven cost:
+    // each thread starts on its own contiguous share and, once that runs out, steals the back half of
+    // another thread's remaining share.
+    void parallelForEach(int count, const IndexFunction &function);
+
+private:
+    void workerLoop(int worker);
+
+    void runChunk(int worker);
+
+    std::vector<std::thread> workers;
+    std::mutex dispatchMutex; // held by the thread whose job the workers are running
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+
+    const RangeFunction *currentFunction;
+    int currentCount;
+    unsigned long generation;
+    int pendingWorkers;
+    bool stopping;
+};
+
+// The process-wide pool that rendering, frame capture and the simulation share, so together they use each core
+// once. Created on first use with `threadCount` threads (0 = one per core); later arguments are ignored.
+ThreadPool &sharedThreadPool(int threadCount = 0);
+
+#endif //LIQUIDFUN_EVO_SIM_THREAD_POOL_H
@@ -0,0 +1,86 @@
+#include <GLFW/glfw3.h>
+#include <cstdio>
+#include <string>
+#include "rendering.h"
+#include "snapshot_ring.h"
+
+// A simulation that crashed or was killed never clears writerActive, so a ring whose sequence has not moved
+// for this long is treated as abandoned too. Keep it above the time between publishes (--publish-every).
+const double STALL_SECONDS = 5.0;
+
+// Attaches to the snapshot ring published by a running simulation (--publish) and draws it. The simulation
+// never waits for this process, so viewers can be started and closed at any time.
+int main(int argc, char **argv) {
+    std::string ringName = argc > 1 ? argv[1] : DEFAULT_SNAPSHOT_RING_NAME;
+
+    GLFWwindow *window = initGLFW();
+    if (!window) {
+        return 1;
+    }
+
+    SnapshotRingReader reader;
+    WorldSnapshot copy;
+    double lastAttachAttempt = -1.0;
+    uint64_t lastSequence = 0;
+    double lastProgress = glfwGetTime();
+    char title[128];
+
+    while (!glfwWindowShouldClose(window)) {
+        double now = glfwGetTime();
+        uint64_t sequence = reader.getLatestSequence();
+        if (sequence != lastSequence) {
+            lastSequence = sequence;
+            lastProgress = now;
+        }
+        bool stalled = reader.isOpen() && now - lastProgress > STALL_SECONDS;
+
+        // (Re)attach at most once a second while the simulation is not running, so a restarted simulation's
+        // new ring is picked up
+        if ((!reader.isWriterActive() || stalled) && now - lastAttachAttempt > 1.0) {
+            lastAttachAttempt = now;
+            reader.open(ringName);
+        }
+
+        bool drawn = false;
+        SnapshotRingView view;
+        if (reader.isOpen() && reader.beginRead(view)) {
+            // Draw straight from shared memory. If the simulation lapped the ring meanwhile, fall back to
+            // copying the latest slot out first, which is short enough to succeed almost immediately.
+            drawSnapshotData(view.polygons, view.polygonCount, view.particles, view.particleCount, view.worldSize);
+            drawn = reader.endRead(view);
+
+            for (int attempt = 0; attempt < 16 && !drawn; ++attempt) {
+                if (!reader.beginRead(view)) {
+                    continue;
+                }
+                copy.tick = view.tick;
+                copy.worldSize = view.worldSize;
+                copy.polygons.assign(view.polygons, view.polygons + view.polygonCount);
+                copy.particles.assign(view.particles, view.particles + view.particleCount);
+                if (reader.endRead(view)) {
+                    drawSnapshot(copy);
+                    drawn = true;
+                }
+            }
+        }
+
+        if (drawn) {
+            snprintf(title, sizeof(title), "Viewer: %s tick %lu%s", ringName.c_str(), view.tick,
+                     stalled ? " (not updating)" : "");
+        } else {
+            glClearColor(0, 0, 0, 1);
+            glClear(GL_COLOR_BUFFER_BIT);
+            snprintf(title, sizeof(title), "Viewer: waiting for %s", ringName.c_str());
+        }
+        glfwSetWindowTitle(window, title);
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    reader.close();
+    cleanUpScene();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "world_snapshot.h"
+
+void makeSnapshotPolygon(const Creature *creature, b2Body *body, const b2PolygonShape *shape,
+                         SnapshotPolygon &polygon) {
+    auto *bodyData = static_cast<BodyData *>(body->GetUserData());
+
+    polygon.position = body->GetPosition();
+    polygon.angle = body->GetAngle();
+    if (bodyData) {
+        polygon.r = bodyData->r;
+        polygon.g = bodyData->g;
+        polygon.b = bodyData->b;
+    } else {
+        polygon.r = 1.0f;
+        polygon.g = 0.0f;
+        polygon.b = 0.0f;
+    }
+    polygon.health = creature->getHealth();
+    polygon.vertexCount = shape->GetVertexCount();
+    for (int i = 0; i < polygon.vertexCount; ++i) {
+        polygon.vertices[i] = shape->GetVertex(i);
+    }
+}
+
+void captureWorldSnapshot(const std::list<Creature *> &creatureList, b2ParticleSystem *particleSystem,
+                          float worldSize, unsigned long tick, WorldSnapshot &snapshot) {
+    snapshot.tick = tick;
+    snapshot.worldSize = worldSize;
+    snapshot.polygons.clear();
+
+    for (const Creature *creature: creatureList) {
+        for (b2Body *body: creature->getBodyParts()) {
+            for (b2Fixture *fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+                if (fixture->GetType() != b2Shape::e_polygon) {
+                    continue;
+                }
+
+                SnapshotPolygon polygon;
+                makeSnapshotPolygon(creature, body, static_cast<b2PolygonShape *>(fixture->GetShape()), polygon);
+                snapshot.polygons.push_back(polygon);
+            }
+        }
+    }
+
+    int particleCount = particleSystem->GetParticleCount();
+    const b2Vec2 *positions = particleSystem->GetPositionBuffer();
+    snapshot.particles.assign(positions, positions + particleCount);
+}
@@ -0,0 +1,37 @@
+#ifndef LIQUIDFUN_EVO_SIM_WORLD_SNAPSHOT_H
+#define LIQUIDFUN_EVO_SIM_WORLD_SNAPSHOT_H
+
+#include <Box2D/Box2D.h>
+#include <Box2D/Particle/b2ParticleSystem.h>
+#include <list>
+#include <vector>
+#include "creature.h"
+
+// One polygon fixture of a creature body, with everything needed to draw it without touching Box2D.
+// Plain data so it can be copied around with memcpy and placed in shared memory.
+struct SnapshotPolygon {
+    b2Vec2 position;
+    float angle;
+    // Base color from BodyData; renderers scale green by health the same way drawCreature does
+    float r, g, b;
+    float health;
+    int vertexCount;
+    b2Vec2 vertices[b2_maxPolygonVertices]; // body-local
+};
+
+// Plain copy of the drawable state of the world for a single tick.
+struct WorldSnapshot {
+    unsigned long tick = 0;
+    float worldSize = 0.0f;
+    std::vector<SnapshotPolygon> polygons;
+    std::vector<b2Vec2> particles;
+};
+
+// Fills `polygon` from one polygon fixture of a creature body.
+void makeSnapshotPolygon(const Creature *creature, b2Body *body, const b2PolygonShape *shape,
+                         SnapshotPolygon &polygon);
+
+void captureWorldSnapshot(const std::list<Creature *> &creatureList, b2ParticleSystem *particleSystem,
+                          float worldSize, unsigned long tick, WorldSnapshot &snapshot);
+
+#endif //LIQUIDFUN_EVO_SIM_WORLD_SNAPSHOT_H